@@ -1,21 +1,218 @@
 #include "FT/abyft.h"
+#include "FT/atlas.h"
+#include "FT/cache_manifest.h"
+#include "FT/kernels.h"
+#include "FT/mapped_file.h"
+#include "FT/packer.h"
+#include "FT/png_encoder.h"
 #include "FT/serializer.h"
+#include "FT/thread_pool.h"
 
 #include <freetype/freetype.h>
-#include <stb/stb_image_write.h>
+#include <freetype/ftmodapi.h>
+#include <freetype/ftsizes.h>
 #include <PrettyPrint/PrettyPrint.h>
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <format>
+#include <fstream>
 #include <iostream>
+#include <optional>
+#include <string_view>
+#include <thread>
 
 namespace aby::ft {
 
+	namespace {
+
+		constexpr u32 GLYPH_CACHE_MAGIC = 0x54464241; // "ABFT"
+
+		// Every field is explicitly sized so the header has no padding and the file is byte for byte deterministic.
+		struct GlyphCacheHeader {
+			u32 magic               = GLYPH_CACHE_MAGIC;
+			u32 format_version      = 0;
+			u32 library_version     = 0;
+			u32 record_size         = sizeof(Glyph);
+			u64 glyph_count         = 0;
+			u64 glyph_offset        = 0; // From the start of the file, glyphs are an array of sorted Glyph records.
+			u32 page_count          = 0;
+			EAtlasFormat format     = EAtlasFormat::RGBA8;
+			float text_height       = 0.f;
+			u32 is_mono             = 0;
+			u64 hash_offset         = 0; // PerfectGlyphHash seeds followed by one slot per glyph, 0 if absent.
+			u32 hash_seed_count     = 0;
+			u32 coverage_count      = 0; // CharRange runs of the cmap, stored after the page table.
+			ERenderMode render_mode = ERenderMode::COVERAGE;
+			u32 pt                  = 0;
+			u32 sdf_spread          = 0;
+			ECacheLayout layout     = ECacheLayout::FILES;
+			u64 key                 = 0; // Library::cache_key of the entry, a mismatch means the file is not what its name claims.
+		};
+		static_assert(sizeof(GlyphCacheHeader) == 88);
+
+		struct GlyphCachePage {
+			u32 width        = 0;
+			u32 height       = 0;
+			u64 pixel_offset = 0; // ECacheLayout::BUNDLE only, texels of the page from the start of the file.
+		};
+
+		// FontData::storage of a fresh bake, its pages point into it like bundled pages point into the mapping when loaded.
+		struct BakedFont {
+			std::vector<Glyph> records                     = {};
+			std::vector<std::vector<unsigned char>> pages = {};
+		};
+
+		// Pages as the manifest lists them, bundle texels by their offset from base, the start of the mapped file.
+		std::vector<CacheManifestPage> manifest_pages(const FontData& data, const std::byte* base) {
+			std::vector<CacheManifestPage> pages;
+			pages.reserve(data.pages.size());
+			for (const auto& page : data.pages) {
+				u64 offset = page.pixels.empty() ? 0 : static_cast<u64>(reinterpret_cast<const std::byte*>(page.pixels.data()) - base);
+				pages.push_back(CacheManifestPage{ .width = page.width, .height = page.height, .offset = offset });
+			}
+			return pages;
+		}
+
+		constexpr u64 align_up(u64 value, u64 alignment) {
+			return (value + alignment - 1) / alignment * alignment;
+		}
+
+		struct StagedGlyph {
+			char32_t character;
+			Glyph glyph;
+			std::vector<unsigned char> bitmap;
+		};
+
+		void rasterize_glyph(FT_Face face, char32_t c, ERenderMode mode, std::optional<StagedGlyph>& out) {
+			if (mode == ERenderMode::SDF) {
+				// Hinting snaps to the bake size's pixel grid, which is wrong at every other size.
+				if (::FT_Load_Char(face, c, FT_LOAD_NO_HINTING))
+					return;
+				if (face->glyph->outline.n_contours > 0 && ::FT_Render_Glyph(face->glyph, FT_RENDER_MODE_SDF))
+					return; // Blank glyphs (space) keep their metrics with an empty bitmap.
+			} else if (::FT_Load_Char(face, c, FT_LOAD_RENDER | FT_LOAD_FORCE_AUTOHINT | FT_LOAD_TARGET_LIGHT)) {
+				return; // If it is not a valid character, skip it
+			}
+
+			auto* glyph = face->glyph;
+			auto* bmp   = &glyph->bitmap;
+
+			StagedGlyph& sg  = out.emplace();
+			sg.character     = c;
+			sg.glyph.advance = static_cast<u32>(glyph->advance.x >> 6u);
+			sg.glyph.bearing = { static_cast<float>(glyph->bitmap_left), static_cast<float>(glyph->bitmap_top) };
+			sg.glyph.size    = { static_cast<float>(bmp->width), static_cast<float>(bmp->rows) };
+			sg.bitmap.resize(std::size_t(bmp->width) * bmp->rows);
+			blit_rows(top_row(bmp->buffer, bmp->pitch, bmp->rows), bmp->pitch, sg.bitmap.data(), bmp->width, bmp->width, bmp->rows);
+		}
+
+		// Appends every printable codepoint of a UTF-8 string, malformed sequences are skipped.
+		void decode_utf8(std::string_view text, std::vector<char32_t>& out) {
+			std::size_t i = 0;
+			while (i < text.size()) {
+				auto lead      = static_cast<unsigned char>(text[i++]);
+				u32 len        = lead < 0x80 ? 0 : lead >= 0xF8 ? 4 : lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : 4;
+				char32_t c     = len == 0 ? lead : lead & (0x3F >> len);
+				bool malformed = len > 3 || i + len > text.size();
+				for (u32 j = 0; j < len && !malformed; ++j) {
+					auto cont = static_cast<unsigned char>(text[i + j]);
+					malformed = (cont & 0xC0) != 0x80;
+					c         = (c << 6) | (cont & 0x3F);
+				}
+				if (malformed) continue; // Resync on the next byte.
+				i += len;
+
+				constexpr char32_t MIN_VALUE[] = { 0, 0x80, 0x800, 0x10000 };
+				if (c < MIN_VALUE[len] || c > MAX_CODEPOINT || (c >= 0xD800 && c <= 0xDFFF)) continue; // Overlong or not a scalar value.
+				if (c < 0x20 || c == 0x7F || c == 0xFEFF) continue;                                   // Control characters and BOM have no glyph.
+				out.push_back(c);
+			}
+		}
+
+		u32 bake_pt(const FontCfg& cfg) {
+			return cfg.render_mode == ERenderMode::SDF ? cfg.sdf_pt : cfg.pt;
+		}
+
+		u32 sdf_spread(const FontCfg& cfg) {
+			return std::clamp(cfg.sdf_spread, 2u, 32u); // Range accepted by FreeType.
+		}
+
+		Coverage scan_coverage(FT_Face face) {
+			std::vector<CharRange> ranges;
+			FT_UInt index = 0;
+			FT_ULong c    = ::FT_Get_First_Char(face, &index);
+			while (index != 0) {
+				auto cp = static_cast<char32_t>(c);
+				if (!ranges.empty() && ranges.back().end == cp) {
+					++ranges.back().end;
+				} else {
+					ranges.push_back(CharRange{ .start = cp, .end = cp + 1 });
+				}
+				c = ::FT_Get_Next_Char(face, c, &index);
+			}
+			return Coverage(ranges);
+		}
+
+		std::filesystem::path page_path(const std::filesystem::path& png_file, u32 page) {
+			if (page == 0) return png_file;
+			auto path = png_file;
+			path.replace_filename(png_file.stem().string() + "_" + std::to_string(page) + png_file.extension().string());
+			return path;
+		}
+
+	} // namespace
+
+	std::vector<char32_t> FontCfg::codepoints() const {
+		std::vector<char32_t> out;
+		auto add_range = [&](CharRange r) {
+			for (char32_t c = r.start; c < r.end; ++c) {
+				out.push_back(c);
+			}
+		};
+		add_range(range);
+		for (CharRange r : ranges) {
+			add_range(r);
+		}
+		if (!charset.empty()) {
+			std::ifstream file(charset, std::ios::binary);
+			if (file) {
+				std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+				decode_utf8(text, out);
+			} else {
+				FT_WARN("Failed to open charset file: {}", charset.string());
+			}
+		}
+		std::sort(out.begin(), out.end());
+		out.erase(std::unique(out.begin(), out.end()), out.end());
+		return out;
+	}
+
+	const Glyph* FontData::find(char32_t c) const {
+		if (lookup == EGlyphLookup::DENSE) {
+			return dense.find(c);
+		}
+		if (lookup == EGlyphLookup::PERFECT_HASH) {
+			return hash.find(c);
+		}
+		auto it = std::lower_bound(records.begin(), records.end(), c, [](const Glyph& glyph, char32_t c) {
+			return glyph.codepoint < c;
+		});
+		return it != records.end() && it->codepoint == c ? &*it : nullptr;
+	}
+
 	Library::Library() {
 		FT_CHECK(::FT_Init_FreeType(&m_Library));
 	}
 
 	Library::~Library() {
+		m_Pool.reset(); // Finish queued work while the FT_Library is still alive.
+		m_Writer.reset(); // Then the cache writes it queued.
+		for (FT_Face face : m_IdleFaces) {
+			::FT_Done_Face(face);
+		}
 		FT_CHECK(::FT_Done_FreeType(m_Library));
 	}
 
@@ -25,30 +222,290 @@ namespace aby::ft {
 	}
 
 	FontData Library::create_font_data(const std::filesystem::path& cache_dir, const FontCfg& cfg) {
-		FontData data =  load_glyph_range(cache_dir, cfg);
+		LoadContext ctx;
+		FontData data = load_glyph_range(ctx, cache_dir, cfg);
 		if (cfg.verbose) {
-			m_VerboseStream.clear();
-			util::pretty_print(m_VerboseStream.str(), "AbyssFreetype");
+			flush_log(ctx);
 		}
 		return data;
 	}
 
-	::FT_FaceRec_* Library::create_face(const FontCfg& cfg) {
-		FT_Face face         = nullptr;
-		std::string path_str = cfg.path.string();
-		FT_CHECK(::FT_New_Face(m_Library, path_str.c_str(), FT_Long(0), &face));
-		FT_CHECK(::FT_Set_Char_Size(face, FT_F26Dot6(0), cfg.pt << 6u, static_cast<FT_UInt>(cfg.dpi.x), static_cast<FT_UInt>(cfg.dpi.y)));
+	std::future<FontData> Library::create_font_data_async(const std::filesystem::path& cache_dir, const FontCfg& cfg, std::stop_token cancel) {
+		return pool().submit([this, cache_dir, cfg, cancel = std::move(cancel)] {
+			if (cancel.stop_requested()) {
+				return FontData{};
+			}
+			LoadContext ctx{ .cancel = cancel };
+			FontData data = load_glyph_range(ctx, cache_dir, cfg);
+			if (cfg.verbose) {
+				flush_log(ctx);
+			}
+			return data;
+		});
+	}
+
+	std::vector<FontData> Library::create_font_data_batch(const std::filesystem::path& cache_dir, std::span<const FontCfg> cfgs) {
+		std::vector<FontData> out(cfgs.size());
+		if (cfgs.empty()) return out;
+
+		// Configs of the same font file share one face, large groups are split so every worker has something to do.
+		std::vector<std::vector<std::size_t>> groups;
+		std::unordered_map<std::string, std::size_t> group_of;
+		for (std::size_t i = 0; i < cfgs.size(); ++i) {
+			auto [it, inserted] = group_of.try_emplace(cfgs[i].path.lexically_normal().string(), groups.size());
+			if (inserted) groups.emplace_back();
+			groups[it->second].push_back(i);
+		}
+		auto load = [this, &cache_dir, cfgs, &out](std::span<const std::size_t> indices) {
+			FT_Face face = nullptr;
+			for (std::size_t i : indices) {
+				LoadContext ctx;
+				out[i] = load_glyph_range(ctx, cache_dir, cfgs[i], &face);
+				if (cfgs[i].verbose) {
+					flush_log(ctx);
+				}
+			}
+			if (face) {
+				release_face(face);
+			}
+		};
+		if (ThreadPool::on_worker()) {
+			// Waiting on the pool from one of its own workers deadlocks once every worker does the same.
+			for (const auto& group : groups) {
+				load(group);
+			}
+			return out;
+		}
+
+		ThreadPool& workers = pool();
+		std::size_t chunk   = std::max<std::size_t>(1, (cfgs.size() + workers.size() - 1) / workers.size());
+
+		std::vector<std::future<void>> tasks;
+		for (const auto& group : groups) {
+			for (std::size_t begin = 0; begin < group.size(); begin += chunk) {
+				std::span<const std::size_t> indices(group.begin() + begin, std::min(group.size(), begin + chunk) - begin);
+				tasks.push_back(workers.submit([&load, indices] { load(indices); }));
+			}
+		}
+		for (auto& task : tasks) {
+			task.get();
+		}
+		return out;
+	}
+
+	ThreadPool& Library::pool() {
+		std::call_once(m_PoolOnce, [this] { m_Pool = std::make_unique<ThreadPool>(); });
+		return *m_Pool;
+	}
+
+	ThreadPool& Library::writer() {
+		std::call_once(m_WriterOnce, [this] { m_Writer = std::make_unique<ThreadPool>(1); });
+		return *m_Writer;
+	}
+
+	void Library::flush() {
+		std::unique_lock lock(m_WriteMutex);
+		m_WriteDone.wait(lock, [this] { return m_PendingWrites.empty(); });
+	}
+
+	void Library::wait_cache_write(const std::filesystem::path& glyph_file) {
+		std::unique_lock lock(m_WriteMutex);
+		m_WriteDone.wait(lock, [&] { return !m_PendingWrites.contains(glyph_file.string()); });
+	}
+
+	void Library::queue_cache_write(LoadContext& ctx, const std::filesystem::path& glyph_file, const FontData& data, const FontCfg& cfg) {
+		// Records, hash and bundle pages live in data.storage, which the copy keeps alive. The glyph map is not written.
+		FontData snapshot{
+			.pages       = data.pages,
+			.format      = data.format,
+			.render_mode = data.render_mode,
+			.pt          = data.pt,
+			.sdf_spread  = data.sdf_spread,
+			.key         = data.key,
+			.records     = data.records,
+			.storage     = data.storage,
+			.hash        = data.hash,
+			.coverage    = data.coverage,
+		};
+		snapshot.text_height = data.text_height;
+		snapshot.is_mono     = data.is_mono;
+		FontCfg write_cfg    = cfg;
+		write_cfg.on_batch   = nullptr; // May capture the caller's stack.
+		{
+			std::lock_guard lock(m_WriteMutex);
+			++m_PendingWrites[glyph_file.string()];
+		}
+		writer().submit([this, glyph_file, snapshot = std::move(snapshot), write_cfg = std::move(write_cfg), page_writes = std::move(ctx.page_writes)]() mutable {
+			// Pages before the glyph file and only if all of them were written, a glyph file on disk always has its pages.
+			bool written = true;
+			for (auto& write_page : page_writes) {
+				written = write_page() && written;
+			}
+			if (!written) {
+				FT_WARN("Cached font pages failed to write, not caching glyphs: {}", glyph_file.string());
+			} else if (auto entry = cache_glyphs(glyph_file, snapshot, write_cfg)) {
+				std::lock_guard lock(m_ManifestMutex);
+				manifest(glyph_file.parent_path()).insert(*entry);
+			}
+			{
+				std::lock_guard lock(m_WriteMutex);
+				if (--m_PendingWrites[glyph_file.string()] == 0) {
+					m_PendingWrites.erase(glyph_file.string());
+				}
+			}
+			m_WriteDone.notify_all();
+		});
+		ctx.page_writes.clear();
+	}
+
+	std::shared_lock<std::shared_mutex> Library::lock_sdf_spread(u32 spread) {
+		std::shared_lock lock(m_SdfMutex);
+		while (m_SdfSpread != spread) {
+			// Bakes with the same spread render concurrently, a different spread waits for them to finish.
+			lock.unlock();
+			{
+				std::unique_lock write(m_SdfMutex);
+				if (m_SdfSpread != spread) {
+					FT_CHECK(::FT_Property_Set(m_Library, "sdf", "spread", &spread));
+					FT_CHECK(::FT_Property_Set(m_Library, "bsdf", "spread", &spread));
+					m_SdfSpread = spread;
+				}
+			}
+			lock.lock();
+		}
+		return lock;
+	}
+
+	void Library::flush_log(LoadContext& ctx) {
+		std::lock_guard lock(m_PrintMutex);
+		util::pretty_print(ctx.log, "AbyssFreetype");
+		ctx.log.clear();
+	}
+
+	::FT_FaceRec_* Library::acquire_face(const FontCfg& cfg) {
+		FT_Face face    = nullptr;
+		std::string key = cfg.path.lexically_normal().string();
+		{
+			// FT_New_Face and FT_Done_Face modify the library, the faces themselves are used lock free.
+			std::lock_guard lock(m_FaceMutex);
+			auto idle = std::find_if(m_IdleFaces.begin(), m_IdleFaces.end(), [&](FT_Face f) { return m_Faces.at(f).path == key; });
+			if (idle != m_IdleFaces.end()) {
+				face = *idle;
+				m_IdleFaces.erase(idle);
+			} else {
+				std::shared_ptr<const MappedFile> file = cfg.map_font ? map_font_file(key) : nullptr;
+				if (file) {
+					FT_CHECK(::FT_New_Memory_Face(m_Library, reinterpret_cast<const FT_Byte*>(file->data()), static_cast<FT_Long>(file->size()), FT_Long(0), &face));
+				} else {
+					FT_CHECK(::FT_New_Face(m_Library, key.c_str(), FT_Long(0), &face));
+				}
+				m_Faces.emplace(face, CachedFace{ .path = key, .file = std::move(file) });
+			}
+		}
+		set_face_size(face, cfg);
 		return face;
 	}
 
-	void Library::destroy_face(::FT_FaceRec_* face, const FontCfg& cfg) {
-		::FT_Done_Face(face);
+	std::shared_ptr<const MappedFile> Library::map_font_file(const std::string& path) {
+		auto& slot = m_FontFiles[path];
+		if (auto file = slot.lock()) {
+			return file;
+		}
+		auto file = std::make_shared<const MappedFile>(path);
+		if (!file->is_open()) {
+			m_FontFiles.erase(path);
+			return nullptr;
+		}
+		slot = file;
+		return file;
 	}
 
-	FontData Library::load_glyph_range(const std::filesystem::path& cache_dir, const FontCfg& cfg) {
+	void Library::set_face_size(::FT_FaceRec_* face, const FontCfg& cfg) {
+		auto dpi_x = static_cast<FT_UInt>(cfg.dpi.x);
+		auto dpi_y = static_cast<FT_UInt>(cfg.dpi.y);
+		u64 key    = u64(bake_pt(cfg)) | u64(dpi_x & 0xFFFF) << 32 | u64(dpi_y & 0xFFFF) << 48;
+		CachedFace* cached;
+		{
+			std::lock_guard lock(m_FaceMutex);
+			cached = &m_Faces.at(face); // Nodes are stable, only the lookup needs the lock.
+		}
+
+		if (auto it = cached->sizes.find(key); it != cached->sizes.end()) {
+			FT_CHECK(::FT_Activate_Size(it->second));
+			return;
+		}
+		if (cached->sizes.size() >= s_MaxFaceSizes) {
+			for (auto& [_, size] : cached->sizes) {
+				::FT_Done_Size(size);
+			}
+			cached->sizes.clear();
+		}
+		FT_Size size = nullptr;
+		FT_CHECK(::FT_New_Size(face, &size));
+		FT_CHECK(::FT_Activate_Size(size));
+		FT_CHECK(::FT_Set_Char_Size(face, FT_F26Dot6(0), bake_pt(cfg) << 6u, dpi_x, dpi_y));
+		cached->sizes.emplace(key, size);
+	}
+
+	void Library::release_face(::FT_FaceRec_* face) {
+		std::lock_guard lock(m_FaceMutex);
+		if (m_Faces.at(face).stale) {
+			destroy_face(face);
+			return;
+		}
+		m_IdleFaces.push_front(face);
+		while (m_IdleFaces.size() > s_MaxIdleFaces) {
+			FT_Face oldest = m_IdleFaces.back();
+			m_IdleFaces.pop_back();
+			destroy_face(oldest);
+		}
+	}
+
+	void Library::destroy_face(::FT_FaceRec_* face) {
+		auto node = m_Faces.extract(face); // Keeps the mapping alive until the face is gone.
+		::FT_Done_Face(face);              // Frees its sizes too.
+		auto& file = node.mapped().file;
+		auto it    = m_FontFiles.find(node.mapped().path);
+		if (file && file.use_count() == 1 && it != m_FontFiles.end() && it->second.lock() == file) {
+			m_FontFiles.erase(it); // Only our own mapping, the file may have been mapped again since it changed.
+		}
+	}
+
+	void Library::evict_faces(const std::string& path) {
+		std::lock_guard lock(m_FaceMutex);
+		for (auto it = m_IdleFaces.begin(); it != m_IdleFaces.end();) {
+			if (m_Faces.at(*it).path != path) {
+				++it;
+				continue;
+			}
+			destroy_face(*it);
+			it = m_IdleFaces.erase(it);
+		}
+		for (auto& [face, cached] : m_Faces) {
+			if (cached.path == path) {
+				cached.stale = true; // Leased faces finish their bake, then go.
+			}
+		}
+		m_FontFiles.erase(path);
+	}
+
+	FontData Library::load_glyph_range(LoadContext& ctx, const std::filesystem::path& cache_dir, const FontCfg& cfg, ::FT_FaceRec_** shared_face) {
+		if (cfg.max_page_size == 0 || cfg.max_page_size > s_MaxPageSize) {
+			FT_ERROR("Max page size {} of {} is not in [1, {}]", cfg.max_page_size, cfg.path.string(), s_MaxPageSize);
+			return FontData{};
+		}
 		auto name       = cfg.path.filename().string();
-		auto glyph_file = cache_path(cache_dir, name, ".bin", cfg);
-		auto png_file   = cache_path(cache_dir, name, ".png", cfg);
+		auto codepoints = cfg.codepoints();
+		auto hashed     = cache_key(cfg, codepoints);
+		if (!hashed) {
+			FT_ERROR("Failed to read font file: {}", cfg.path.string());
+			return FontData{};
+		}
+		u64 key         = *hashed;
+		bool bundle     = cfg.cache_layout == ECacheLayout::BUNDLE;
+		auto glyph_file = cache_path(cache_dir, name, bundle ? ".abft" : ".bin", key);
+		auto png_file   = cache_path(cache_dir, name, ".png", key);
+		auto raw_file   = cache_path(cache_dir, name, ".atlas", key);
 		FontData out;
 
 		std::chrono::time_point<std::chrono::high_resolution_clock> start;
@@ -56,186 +513,620 @@ namespace aby::ft {
 			start = std::chrono::high_resolution_clock::now();
 		}
 
-		if (std::filesystem::exists(png_file) && std::filesystem::exists(glyph_file)) {
+		wait_cache_write(glyph_file); // An entry this process is still writing is loaded once it is complete.
+		auto fonts_dir = glyph_file.parent_path();
+		std::optional<CacheManifestEntry> listed;
+		{
+			std::lock_guard lock(m_ManifestMutex);
+			listed = manifest(fonts_dir).find(key);
+		}
+
+		// Opening the file is the existence check, a hit costs one open and one map.
+		auto mapping = std::make_shared<MappedFile>(glyph_file);
+		bool cached  = mapping->is_open();
+		if (cached) {
 			if (cfg.verbose) {
-				m_VerboseStream << std::format("  Loading font from cache: \x1b[4;34m{}\x1b[0m\n\n", glyph_file.string());
+				ctx.log += std::format("  Loading font from cache: \x1b[4;34m{}\x1b[0m\n\n", glyph_file.string());
 			}
-			out = load_glyph_range_bin(glyph_file, cfg);
-		} else {
+			u64 size         = mapping->size();
+			const auto* base = mapping->data();
+			auto cached_data = load_glyph_range_bin(glyph_file, std::move(mapping), png_file, raw_file, cfg, key);
+			cached           = cached_data.has_value();
+			if (cached) {
+				out = std::move(*cached_data);
+			}
+			// A listed entry was complete when recorded, it is loaded without probing the page files it lists.
+			// Others are probed, write_png/write_raw are not part of the key and may ask for files never written.
+			CacheManifestEntry entry{
+				.key         = key,
+				.size        = size,
+				.glyph_count = out.records.size(),
+				.layout      = cfg.cache_layout,
+				.png         = !bundle && cfg.write_png,
+				.raw         = !bundle && cfg.write_raw,
+				.pages       = manifest_pages(out, base),
+			};
+			bool same    = listed && listed->size == size && listed->layout == entry.layout && listed->glyph_count == entry.glyph_count && listed->pages == entry.pages;
+			bool trusted = cached && same && listed->covers(cfg);
+			for (std::size_t i = 0; cached && !trusted && !bundle && i < out.pages.size(); ++i) {
+				const AtlasPage& page = out.pages[i];
+				if ((cfg.write_png && !std::filesystem::exists(page.png)) || (cfg.write_raw && !std::filesystem::exists(page.raw))) {
+					FT_WARN("Cached font page is missing, reloading font: {}", glyph_file.string());
+					cached = false;
+				}
+			}
+			if (cached && !trusted) {
+				entry.png = entry.png || (same && listed->png); // Files listed for this glyph file are still claimed.
+				entry.raw = entry.raw || (same && listed->raw);
+				std::lock_guard lock(m_ManifestMutex); // Indexes caches baked before the manifest or by another process.
+				manifest(fonts_dir).insert(entry);
+			}
+		}
+		if (!cached) {
 			if (cfg.verbose) {
-				m_VerboseStream << std::format("  Loading font from file: \x1b[4;34m{}\x1b[0m\n\n", cfg.path.string());
+				ctx.log += std::format("  Loading font from file: \x1b[4;34m{}\x1b[0m\n\n", cfg.path.string());
+			}
+			std::error_code ec; // Another thread may create it first.
+			std::filesystem::create_directories(fonts_dir, ec);
+			FT_Face face = nullptr;
+			if (shared_face && *shared_face) {
+				face = *shared_face;
+				set_face_size(face, cfg);
+			} else {
+				face = acquire_face(cfg);
+			}
+			std::optional<FontData> baked = load_glyph_range_ttf(ctx, face, codepoints, png_file, raw_file, cfg);
+			bool dropped                  = !baked || ctx.cancel.stop_requested(); // Read once, a font is either cached and returned whole or neither.
+			if (baked) {
+				out     = std::move(*baked);
+				out.key = key;
+			}
+			if (dropped) {
+				out = FontData{}; // Failed or possibly partial, never cached.
+			} else if (cfg.write_behind) {
+				if (cfg.verbose) {
+					ctx.log += std::format("  Writing cache in the background: \x1b[4;34m{}\x1b[0m\n\n", glyph_file.string());
+				}
+				queue_cache_write(ctx, glyph_file, out, cfg);
+			} else if (!ctx.pages_written) {
+				FT_WARN("Cached font pages failed to write, not caching glyphs: {}", glyph_file.string());
+			} else if (auto entry = cache_glyphs(glyph_file, out, cfg)) {
+				std::lock_guard lock(m_ManifestMutex);
+				manifest(fonts_dir).insert(*entry);
+			}
+			if (shared_face) {
+				*shared_face = face; // The caller keeps it for the next config of this font.
+			} else {
+				release_face(face);
+			}
+			if (dropped) {
+				return out;
 			}
-			FT_Face face = create_face(cfg);
-			out          = load_glyph_range_ttf(face, png_file, cfg);
-			cache_glyphs(cache_dir, name, out, cfg);
-			destroy_face(face, cfg);
 		}
 
 		if (cfg.verbose) {
 			using clock = std::chrono::high_resolution_clock;
 			using ns    = std::chrono::nanoseconds;
 			float elapsed = std::chrono::duration_cast<ns>(clock::now() - start).count() * 0.001f * 0.001f;
-			m_VerboseStream << std::format("  Font Loading took a total of \x1b[2;38;5;120m{}\x1b[0mms\n", elapsed);
+			ctx.log += std::format("  Font Loading took a total of \x1b[2;38;5;120m{}\x1b[0mms\n", elapsed);
 		}
 
 		out.name = name;
-		out.png  = png_file;
+		out.png  = out.pages.empty() ? std::filesystem::path() : out.pages.front().png;
+		build_lookup(out, cfg);
 		return out;
 	}
 
-	FontData Library::load_glyph_range_ttf(FT_FaceRec_* face, const std::filesystem::path& png_file, const FontCfg& cfg) {
-		u32 tex_width  = 512;
-		u32 tex_height = 512;
-
-		std::vector<char> pixels(tex_width * tex_height, 0); // Initialize pixel buffer with 0 (black)
-
-		int pen_x = 0;
-		int pen_y = 0;
+	void Library::build_lookup(FontData& data, const FontCfg& cfg) {
+		data.lookup = cfg.lookup;
+		if (cfg.lookup == EGlyphLookup::DENSE && !data.records.empty()) {
+			// A handful of glyphs scattered over the whole of unicode would turn into megabytes of sentinels.
+			std::size_t span = data.records.back().codepoint - data.records.front().codepoint + 1;
+			if (span > std::max<std::size_t>(s_MaxDenseSpan, data.records.size() * 4)) {
+				FT_WARN("Glyphs of {} span {} codepoints, too sparse for a dense table. Falling back to perfect hash lookup", data.name, span);
+				data.lookup = EGlyphLookup::PERFECT_HASH;
+			} else {
+				data.dense = DenseGlyphs(data.records);
+			}
+		}
+		if (data.lookup == EGlyphLookup::PERFECT_HASH && data.hash.empty()) {
+			data.hash = PerfectGlyphHash(data.records);
+		}
+	}
 
+	std::optional<FontData> Library::load_glyph_range_ttf(LoadContext& ctx, FT_FaceRec_* face, std::span<const char32_t> requested, const std::filesystem::path& png_file, const std::filesystem::path& raw_file, const FontCfg& cfg) {
 		float max_ascent  = static_cast<float>(face->size->metrics.ascender) / 64.0f;
 		float max_descent = static_cast<float>(face->size->metrics.descender) / 64.0f;
 		FontData out{
 			.glyphs      = {},
 			.text_height = (max_ascent - max_descent) * 0.5f,
 			.is_mono     = static_cast<bool>(face->face_flags & FT_FACE_FLAG_FIXED_WIDTH),
+			.render_mode = cfg.render_mode,
+			.pt          = bake_pt(cfg),
+			.sdf_spread  = cfg.render_mode == ERenderMode::SDF ? sdf_spread(cfg) : 0,
 		};
+		std::shared_lock<std::shared_mutex> sdf_lock;
+		if (cfg.render_mode == ERenderMode::SDF) {
+			sdf_lock = lock_sdf_spread(out.sdf_spread); // Held until every worker rendered with it.
+		}
 
-		for (char32_t c = cfg.range.start; c < cfg.range.end; ++c) {
-			int pad = 1;
-			if (::FT_Load_Char(face, c, FT_LOAD_RENDER | FT_LOAD_FORCE_AUTOHINT | FT_LOAD_TARGET_LIGHT))
-				continue; // If it is not a valid character, continue
+		// Only codepoints the cmap maps are ever loaded, unmapped ones would just render .notdef.
+		out.coverage = scan_coverage(face);
+		std::vector<char32_t> codepoints;
+		codepoints.reserve(requested.size());
+		std::copy_if(requested.begin(), requested.end(), std::back_inserter(codepoints), [&](char32_t c) { return out.coverage.contains(c); });
+		if (cfg.verbose) {
+			ctx.log += std::format("  Skipped {} of {} codepoints not mapped by the font\n\n", requested.size() - codepoints.size(), requested.size());
+		}
 
-			auto* glyph = face->glyph;
-			auto* bmp   = &glyph->bitmap;
+		// Rasterize everything up front so the packer can see every glyph size before placing any.
+		// Every codepoint owns a slot, so the merge below is identical however the work was scheduled.
+		// Streaming bakes instead pack each chunk on this thread as soon as it is rasterized, in order.
+		bool streaming     = static_cast<bool>(cfg.on_batch);
+		std::size_t chunks = (codepoints.size() + s_RasterChunk - 1) / s_RasterChunk;
+		std::vector<std::optional<StagedGlyph>> slots(codepoints.size());
+		// On a pool worker (batch or async loads) the pool already keeps every core busy, like the png encoder.
+		u32 threads = cfg.threads != 0 ? cfg.threads : ThreadPool::on_worker() ? 1 : std::max(1u, std::thread::hardware_concurrency());
+		threads     = std::min<u32>(threads, static_cast<u32>(chunks));
 
-			// If the glyph doesn't fit in the current row, move to the next row
-			if (pen_x + bmp->width >= tex_width) {
-				pen_x  = 0;
-				pen_y += (face->size->metrics.height >> 6) + pad;
-			}
-			vec2 uv_min   = { static_cast<float>(pen_x) / tex_width, static_cast<float>(pen_y) / tex_height };
-			vec2 uv_max   = { static_cast<float>(pen_x + bmp->width) / tex_width, static_cast<float>(pen_y + bmp->rows) / tex_height };
-			vec4 uvs      = { uv_min.x, uv_min.y, uv_max.x, uv_max.y };
-			out.glyphs[c] = Glyph{
-				.advance   = static_cast<u32>(glyph->advance.x >> 6u),
-				.offset    = pen_y * tex_width + pen_x,
-				.bearing   = { static_cast<float>(glyph->bitmap_left), static_cast<float>(glyph->bitmap_top) },
-				.size      = { static_cast<float>(bmp->width), static_cast<float>(bmp->rows) },
-				.texcoords = {
-					{ uvs.x, uvs.y }, // Top-left  (0)
-				    { uvs.z, uvs.y }, // Top-right (1)
-				    { uvs.z, uvs.w }, // Bottom-right (2)
-				    { uvs.x, uvs.w }  // Bottom-left  (3)
-				},
-			};
+		std::mutex chunk_mutex;
+		std::condition_variable_any chunk_cv;
+		std::vector<bool> chunk_done(streaming ? chunks : 0); // Guarded by chunk_mutex.
+		auto raster_chunk = [&](FT_Face worker_face, std::size_t chunk) {
+			std::size_t end = std::min<std::size_t>((chunk + 1) * s_RasterChunk, codepoints.size());
+			for (std::size_t i = chunk * s_RasterChunk; i < end; ++i) {
+				rasterize_glyph(worker_face, codepoints[i], cfg.render_mode, slots[i]);
+			}
+			if (streaming) {
+				{
+					std::lock_guard lock(chunk_mutex);
+					chunk_done[chunk] = true;
+				}
+				chunk_cv.notify_all();
+			}
+		};
+		std::atomic<std::size_t> next = 0;
+		auto work = [&](FT_Face worker_face, std::stop_token stop) {
+			for (std::size_t chunk = next++; chunk < chunks && !ctx.cancel.stop_requested() && !stop.stop_requested(); chunk = next++) {
+				raster_chunk(worker_face, chunk);
+			}
+		};
+
+		// FT_Face is not thread safe, every worker leases its own.
+		std::vector<std::jthread> workers;
+		if (threads > 1) {
+			for (u32 i = 1; i < threads; ++i) {
+				workers.emplace_back([&](std::stop_token stop) {
+					FT_Face worker_face = acquire_face(cfg);
+					work(worker_face, stop);
+					release_face(worker_face);
+				});
+			}
+			if (streaming) {
+				workers.emplace_back([&](std::stop_token stop) { work(face, stop); }); // This thread packs instead.
+			} else {
+				work(face, {});
+			}
+		} else if (!streaming) {
+			work(face, {});
+		}
+
+		bool bundle = cfg.cache_layout == ECacheLayout::BUNDLE;
+		std::vector<std::vector<unsigned char>> pixels;
+		auto add_page = [&](u32 width, u32 height) {
+			u32 i = static_cast<u32>(pixels.size());
+			pixels.emplace_back(std::size_t(width) * height, 0); // Initialize pixel buffer with 0 (black)
+			out.pages.push_back(AtlasPage{
+			    .png    = cfg.write_png && !bundle ? page_path(png_file, i) : std::filesystem::path(),
+			    .raw    = cfg.write_raw && !bundle ? page_path(raw_file, i) : std::filesystem::path(),
+			    .width  = width,
+			    .height = height,
+			});
+		};
+
+		auto baked    = std::make_shared<BakedFont>();
+		auto* records = &baked->records;
+		records->reserve(codepoints.size());
+		auto place = [&](const StagedGlyph& staged, const Rect& rect, u32 page) {
+			u32 tex_width      = out.pages[page].width;
+			u32 tex_height     = out.pages[page].height;
+			Glyph glyph        = staged.glyph;
+			vec2 uv_min        = { static_cast<float>(rect.x) / tex_width, static_cast<float>(rect.y) / tex_height };
+			vec2 uv_max        = { static_cast<float>(rect.x + rect.w) / tex_width, static_cast<float>(rect.y + rect.h) / tex_height };
+			vec4 uvs           = { uv_min.x, uv_min.y, uv_max.x, uv_max.y };
+			glyph.offset       = rect.y * tex_width + rect.x;
+			glyph.page         = page;
+			glyph.codepoint    = staged.character;
+			glyph.texcoords[0] = { uvs.x, uvs.y }; // Top-left  (0)
+			glyph.texcoords[1] = { uvs.z, uvs.y }; // Top-right (1)
+			glyph.texcoords[2] = { uvs.z, uvs.w }; // Bottom-right (2)
+			glyph.texcoords[3] = { uvs.x, uvs.w }; // Bottom-left  (3)
+			records->push_back(glyph); // Placed in ascending codepoint order, so records stay sorted.
 
-			for (unsigned int row = 0; row < bmp->rows; ++row) {
-				for (unsigned int col = 0; col < bmp->width; ++col) {
-					unsigned int x            = pen_x + col;
-					unsigned int y            = pen_y + row;
-					pixels[y * tex_width + x] = bmp->buffer[row * bmp->pitch + col]; // Copy pixel data
+			blit_rows(staged.bitmap.data(), rect.w, &pixels[page][std::size_t(rect.y) * tex_width + rect.x], tex_width, rect.w, rect.h);
+		};
+
+		if (streaming) {
+			OnlineAtlasPacker packer(cfg.max_page_size, cfg.padding);
+			std::vector<unsigned char> texels;
+			for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+				if (threads > 1) {
+					std::unique_lock lock(chunk_mutex);
+					if (!chunk_cv.wait(lock, ctx.cancel, [&] { return chunk_done[chunk]; })) break;
+				} else {
+					if (ctx.cancel.stop_requested()) break;
+					raster_chunk(face, chunk);
+				}
+
+				std::size_t end = std::min<std::size_t>((chunk + 1) * s_RasterChunk, codepoints.size());
+				std::size_t first = records->size();
+				for (std::size_t i = chunk * s_RasterChunk; i < end; ++i) {
+					if (!slots[i]) continue;
+					Rect rect;
+					u32 page = 0;
+					if (!packer.place(static_cast<u32>(slots[i]->glyph.size.x), static_cast<u32>(slots[i]->glyph.size.y), rect, page)) {
+						FT_ERROR("A glyph of {} does not fit into a {}x{} page", cfg.path.string(), cfg.max_page_size, cfg.max_page_size);
+						for (auto& worker : workers) {
+							worker.request_stop(); // Joined on return, skip the chunks nobody will pack.
+						}
+						return std::nullopt;
+					}
+					while (out.pages.size() < packer.page_count()) {
+						add_page(cfg.max_page_size, cfg.max_page_size);
+					}
+					place(*slots[i], rect, page);
+					slots[i].reset();
 				}
+
+				// One batch per page the chunk touched, records of a page are contiguous.
+				u32 texel = texel_size(cfg.format);
+				while (first < records->size()) {
+					u32 page         = (*records)[first].page;
+					std::size_t last = first;
+					u32 x0 = cfg.max_page_size, y0 = cfg.max_page_size, x1 = 0, y1 = 0;
+					for (; last < records->size() && (*records)[last].page == page; ++last) {
+						const Glyph& glyph = (*records)[last];
+						if (glyph.size.x == 0 || glyph.size.y == 0) continue;
+						u32 x = glyph.offset % cfg.max_page_size;
+						u32 y = glyph.offset / cfg.max_page_size;
+						x0    = std::min(x0, x);
+						y0    = std::min(y0, y);
+						x1    = std::max(x1, x + static_cast<u32>(glyph.size.x));
+						y1    = std::max(y1, y + static_cast<u32>(glyph.size.y));
+					}
+					Rect rect = x1 > x0 ? Rect{ .x = x0, .y = y0, .w = x1 - x0, .h = y1 - y0 } : Rect{};
+					texels.resize(std::size_t(rect.w) * rect.h * texel);
+					const unsigned char* src = &pixels[page][std::size_t(rect.y) * cfg.max_page_size + rect.x];
+					if (cfg.format == EAtlasFormat::R8) {
+						blit_rows(src, cfg.max_page_size, texels.data(), rect.w, rect.w, rect.h);
+					} else {
+						for (u32 row = 0; row < rect.h; ++row) {
+							expand_r8_rgba8(src + std::size_t(row) * cfg.max_page_size, &texels[std::size_t(row) * rect.w * 4], rect.w);
+						}
+					}
+					cfg.on_batch(GlyphBatch{
+					    .glyphs      = std::span<const Glyph>(records->data() + first, last - first),
+					    .page        = page,
+					    .page_width  = cfg.max_page_size,
+					    .page_height = cfg.max_page_size,
+					    .rect        = rect,
+					    .pixels      = texels,
+					    .format      = cfg.format,
+					});
+					first = last;
+				}
+			}
+		}
+		workers.clear(); // Joins the raster workers.
+		if (ctx.cancel.stop_requested()) {
+			return std::nullopt; // Skip packing and writing pages, the result would be partial.
+		}
+
+		if (!streaming) {
+			std::vector<StagedGlyph> staged;
+			std::vector<Rect> sizes;
+			staged.reserve(slots.size());
+			sizes.reserve(slots.size());
+			for (auto& slot : slots) {
+				if (!slot) continue;
+				sizes.push_back(Rect{ .w = static_cast<u32>(slot->glyph.size.x), .h = static_cast<u32>(slot->glyph.size.y) });
+				staged.push_back(std::move(*slot));
 			}
 
-			pen_x += bmp->width + pad;
+			AtlasLayout layout;
+			if (!layout_atlas(sizes, cfg.max_page_size, cfg.padding, cfg.uniform_pages, layout)) {
+				FT_ERROR("A glyph of {} does not fit into a {}x{} page", cfg.path.string(), cfg.max_page_size, cfg.max_page_size);
+				return std::nullopt;
+			}
+			for (const auto& page : layout.pages) {
+				add_page(page.width, page.height);
+			}
+			for (std::size_t i = 0; i < staged.size(); ++i) {
+				place(staged[i], layout.rects[i], layout.page[i]);
+			}
 		}
+		out.records = *records;
+		out.storage = baked;
+		out.hash    = PerfectGlyphHash(out.records); // Always built so the cache can serve any lookup later.
+		if (cfg.glyph_map) {
+			out.glyphs.reserve(records->size());
+			for (const Glyph& glyph : *records) {
+				out.glyphs.emplace(glyph.codepoint, glyph);
+			}
+		}
+
+		out.format = cfg.format;
+		u32 comp   = texel_size(cfg.format);
+		for (u32 i = 0; i < out.pages.size(); ++i) {
+			std::vector<unsigned char> expanded;
+			if (cfg.format == EAtlasFormat::RGBA8) {
+				expanded.resize(pixels[i].size() * 4);
+				expand_r8_rgba8(pixels[i].data(), expanded.data(), pixels[i].size());
+			}
+			auto& texels = cfg.format == EAtlasFormat::R8 ? pixels[i] : expanded;
+			// Kept in the baked font either way, so a font returned before its files are written behind can still be uploaded.
+			out.pages[i].pixels = baked->pages.emplace_back(std::move(texels));
+			if (bundle) {
+				continue; // Written into the bundle by cache_glyphs.
+			}
 
-		std::vector<unsigned char> png_data(tex_width * tex_height * 4);
-		for (unsigned int i = 0; i < tex_width * tex_height; ++i) {
-			png_data[i * 4 + 0] = pixels[i]; // Red channel
-			png_data[i * 4 + 1] = pixels[i]; // Green channel
-			png_data[i * 4 + 2] = pixels[i]; // Blue channel
-			png_data[i * 4 + 3] = 0xff;      // Alpha channel (fully opaque)
+			// Copies what it needs, with FontCfg::write_behind it outlives cfg. baked keeps the texels alive.
+			auto write_page = [raw = cfg.write_raw, png = cfg.write_png, format = cfg.format, png_cfg = cfg.png, page = out.pages[i], comp, baked] {
+				if (raw && !write_raw_atlas(page.raw, page.width, page.height, format, page.pixels)) {
+					return false;
+				}
+				return !png || write_png(page.png, page.pixels, page.width, page.height, comp, png_cfg);
+			};
+			if (cfg.write_behind) {
+				ctx.page_writes.emplace_back(std::move(write_page));
+			} else if (!write_page()) {
+				ctx.pages_written = false;
+			}
 		}
 
-		std::string png_file_str = png_file.string();
-		::stbi_write_png(png_file_str.c_str(), tex_width, tex_height, 4, png_data.data(), tex_width * 4);
+		return out;
+	}
+
+	std::optional<FontData> Library::load_glyph_range_bin(const std::filesystem::path& cache, std::shared_ptr<MappedFile> mapping, const std::filesystem::path& png_file, const std::filesystem::path& raw_file, const FontCfg& cfg, u64 key) {
+		Serializer serializer(SerializeOpts{ .file = cache, .mode = ESerializeMode::MAP, .mapping = std::move(mapping) });
+		if (serializer.mapping()->size() < sizeof(GlyphCacheHeader)) {
+			FT_WARN("Cached font glyphs are truncated: {}", cache.string());
+			return std::nullopt;
+		}
+		const GlyphCacheHeader& header = serializer.view<GlyphCacheHeader>(1).front();
+		if (header.magic != GLYPH_CACHE_MAGIC || header.format_version != s_CacheVersion || header.record_size != sizeof(Glyph)) {
+			FT_WARN("Cached font glyphs are stale (format {}, library {}), expected format {}: {}", header.format_version, Version(header.library_version), s_CacheVersion, cache.string());
+			return std::nullopt;
+		}
+		if (header.layout != cfg.cache_layout) {
+			FT_WARN("Cached font glyphs have another cache layout: {}", cache.string());
+			return std::nullopt;
+		}
+		if (header.key != key) {
+			FT_WARN("Cached font glyphs were baked from another font or config (key {:016x}, expected {:016x}): {}", header.key, key, cache.string());
+			return std::nullopt;
+		}
+		// Counts and offsets come from the file, bounds are checked by division so a corrupt header cannot wrap them.
+		u64 file_size  = serializer.mapping()->size();
+		u64 tables_end = sizeof(GlyphCacheHeader) + u64(header.page_count) * sizeof(GlyphCachePage) + u64(header.coverage_count) * sizeof(CharRange);
+		if (tables_end > header.glyph_offset || header.glyph_offset > file_size || header.glyph_offset % s_RecordAlignment != 0 ||
+		    header.glyph_count > (file_size - header.glyph_offset) / sizeof(Glyph))
+		{
+			FT_WARN("Cached font glyphs are truncated: {}", cache.string());
+			return std::nullopt;
+		}
+
+		FontData out{
+			.text_height = header.text_height,
+			.is_mono     = header.is_mono != 0,
+			.format      = header.format,
+			.render_mode = header.render_mode,
+			.pt          = header.pt,
+			.sdf_spread  = header.sdf_spread,
+			.key         = header.key,
+		};
+		auto pages = serializer.view<GlyphCachePage>(header.page_count);
+		out.pages.resize(pages.size());
+		for (u32 i = 0; i < pages.size(); i++) {
+			out.pages[i].png    = cfg.write_png && header.layout == ECacheLayout::FILES ? page_path(png_file, i) : std::filesystem::path();
+			out.pages[i].raw    = cfg.write_raw && header.layout == ECacheLayout::FILES ? page_path(raw_file, i) : std::filesystem::path();
+			out.pages[i].width  = pages[i].width;
+			out.pages[i].height = pages[i].height;
+			if (header.layout == ECacheLayout::BUNDLE) {
+				u64 size = u64(pages[i].width) * pages[i].height * texel_size(header.format);
+				if (pages[i].pixel_offset == 0 || pages[i].pixel_offset > file_size || size > file_size - pages[i].pixel_offset) {
+					FT_WARN("Cached font pages are truncated: {}", cache.string());
+					return std::nullopt;
+				}
+				out.pages[i].pixels = { reinterpret_cast<const unsigned char*>(serializer.mapping()->data() + pages[i].pixel_offset), size };
+			}
+		}
+		auto coverage = serializer.view<CharRange>(header.coverage_count);
+		if (!Coverage::valid(coverage)) {
+			FT_WARN("Cached font coverage is corrupt: {}", cache.string());
+			return std::nullopt;
+		}
+		out.coverage = Coverage(coverage);
+
+		serializer.seek_to(header.glyph_offset);
+		out.records = serializer.view<Glyph>(header.glyph_count);
+		out.storage = serializer.mapping();
+		// Every lookup, the sorted binary search included, relies on strictly ascending codepoints.
+		if (std::adjacent_find(out.records.begin(), out.records.end(), [](const Glyph& a, const Glyph& b) { return a.codepoint >= b.codepoint; }) != out.records.end()) {
+			FT_WARN("Cached font glyphs are out of order: {}", cache.string());
+			return std::nullopt;
+		}
+		if (header.hash_offset != 0) {
+			if (header.hash_offset > file_size || header.hash_offset % alignof(u32) != 0 ||
+			    (u64(header.hash_seed_count) + header.glyph_count) * sizeof(u32) > file_size - header.hash_offset)
+			{
+				FT_WARN("Cached font glyphs are truncated: {}", cache.string());
+				return std::nullopt;
+			}
+			serializer.seek_to(header.hash_offset);
+			auto seeds = serializer.view<u32>(header.hash_seed_count);
+			auto slots = serializer.view<u32>(header.glyph_count);
+			if (!PerfectGlyphHash::valid(out.records.size(), seeds, slots)) {
+				FT_WARN("Cached font glyph hash is corrupt: {}", cache.string());
+				return std::nullopt;
+			}
+			out.hash = PerfectGlyphHash(out.records, seeds, slots);
+		}
+		if (cfg.glyph_map) {
+			out.glyphs.reserve(out.records.size());
+			for (const Glyph& glyph : out.records) {
+				out.glyphs.emplace(glyph.codepoint, glyph);
+			}
+		}
 
 		return out;
 	}
 
-	FontData Library::load_glyph_range_bin(const std::filesystem::path& cache, const FontCfg& cfg) {
-		Serializer serializer(SerializeOpts{ .file = cache, .mode = ESerializeMode::READ });
-		std::uint32_t version = 0;
-		std::size_t glyph_count = 0;
-		FontData out;
+	std::optional<CacheManifestEntry> Library::cache_glyphs(const std::filesystem::path& bin_cache_path, const FontData& data, const FontCfg& cfg) {
+		FT_ASSERT(std::is_sorted(data.records.begin(), data.records.end(), [](const Glyph& a, const Glyph& b) { return a.codepoint < b.codepoint; }), "Glyph records must be sorted by codepoint");
 
-		serializer.read(version);
+		std::vector<GlyphCachePage> pages;
+		pages.reserve(data.pages.size());
+		for (const auto& page : data.pages) {
+			pages.push_back(GlyphCachePage{ .width = page.width, .height = page.height });
+		}
 
-		FT_ASSERT(Version(version) == s_Version, 
-			"  Version of cached font glyphs does not match library version\n"
-			"  File Version:    {}\n"
-			"  Library Version: {}", 
-			Version(version), s_Version
-		);
+		std::vector<CharRange> coverage = data.coverage.ranges();
 
-		serializer.read(glyph_count);
-		serializer.read(out.text_height);
-		serializer.read(out.is_mono);
+		GlyphCacheHeader header{
+			.format_version  = s_CacheVersion,
+			.library_version = s_Version.value,
+			.glyph_count     = data.records.size(),
+			.glyph_offset    = align_up(sizeof(GlyphCacheHeader) + pages.size() * sizeof(GlyphCachePage) + coverage.size() * sizeof(CharRange), s_RecordAlignment),
+			.page_count      = static_cast<u32>(pages.size()),
+			.format          = data.format,
+			.text_height     = data.text_height,
+			.is_mono         = data.is_mono,
+			.coverage_count  = static_cast<u32>(coverage.size()),
+			.render_mode     = data.render_mode,
+			.pt              = data.pt,
+			.sdf_spread      = data.sdf_spread,
+			.layout          = cfg.cache_layout,
+			.key             = data.key,
+		};
+		u64 end = header.glyph_offset + data.records.size_bytes();
+		if (!data.hash.empty()) {
+			header.hash_offset     = end;
+			header.hash_seed_count = static_cast<u32>(data.hash.seeds().size());
+			end += (data.hash.seeds().size() + data.hash.slots().size()) * sizeof(u32);
+		}
+		if (cfg.cache_layout == ECacheLayout::BUNDLE) {
+			// Pages follow the tables, aligned like the records so mapped pixels can be uploaded as is.
+			for (std::size_t i = 0; i < pages.size(); ++i) {
+				pages[i].pixel_offset = align_up(end, s_RecordAlignment);
+				end                   = pages[i].pixel_offset + data.pages[i].pixels.size();
+			}
+		}
 
-		out.glyphs.reserve(glyph_count);
-		for (std::size_t i = 0; i < glyph_count; i++) {
-			char32_t character;
-			Glyph glyph;
-			serializer.read(character);
-			serializer.read(glyph.advance);
-			serializer.read(glyph.offset);
-			serializer.read(glyph.bearing.x);
-			serializer.read(glyph.bearing.y);
-			serializer.read(glyph.size.x);
-			serializer.read(glyph.size.y);
-			serializer.read(glyph.texcoords[0].x);
-			serializer.read(glyph.texcoords[0].y);
-			serializer.read(glyph.texcoords[1].x);
-			serializer.read(glyph.texcoords[1].y);
-			serializer.read(glyph.texcoords[2].x);
-			serializer.read(glyph.texcoords[2].y);
-			serializer.read(glyph.texcoords[3].x);
-			serializer.read(glyph.texcoords[3].y);
-			serializer.read(glyph.reserved);
-			out.glyphs.emplace(character, glyph);
+		Serializer serializer(SerializeOpts{ .file = bin_cache_path, .mode = ESerializeMode::WRITE });
+		serializer.write_span(std::span<const GlyphCacheHeader>(&header, 1));
+		serializer.write_span(std::span<const GlyphCachePage>(pages));
+		serializer.write_span(std::span<const CharRange>(coverage));
+		serializer.align(s_RecordAlignment);
+		serializer.write_span(data.records);
+		if (!data.hash.empty()) {
+			serializer.write_span(data.hash.seeds());
+			serializer.write_span(data.hash.slots());
+		}
+		if (cfg.cache_layout == ECacheLayout::BUNDLE) {
+			for (const auto& page : data.pages) {
+				serializer.align(s_RecordAlignment);
+				serializer.write_span(page.pixels);
+			}
+		}
+		if (!serializer.save()) {
+			return std::nullopt;
 		}
+		bool files = cfg.cache_layout == ECacheLayout::FILES;
+		CacheManifestEntry entry{
+			.key         = data.key,
+			.size        = end,
+			.glyph_count = data.records.size(),
+			.layout      = cfg.cache_layout,
+			.png         = files && cfg.write_png, // Written before the glyph file.
+			.raw         = files && cfg.write_raw,
+		};
+		entry.pages.reserve(pages.size());
+		for (const auto& page : pages) {
+			entry.pages.push_back(CacheManifestPage{ .width = page.width, .height = page.height, .offset = page.pixel_offset });
+		}
+		return entry;
+	}
 
-		return out;
+	CacheManifest& Library::manifest(const std::filesystem::path& dir) {
+		auto& slot = m_Manifests[dir.lexically_normal().string()];
+		if (!slot) {
+			slot = std::make_unique<CacheManifest>(dir);
+		}
+		return *slot;
+	}
+
+	std::optional<u64> Library::font_hash(const std::filesystem::path& font) {
+		std::error_code size_ec, time_ec;
+		auto size  = std::filesystem::file_size(font, size_ec);
+		auto mtime = std::filesystem::last_write_time(font, time_ec);
+		if (size_ec || time_ec) {
+			return std::nullopt;
+		}
+		auto path = font.lexically_normal().string();
+		{
+			std::lock_guard lock(m_HashMutex);
+			if (auto it = m_FontHashes.find(path); it != m_FontHashes.end() && it->second.size == size && it->second.mtime == mtime) {
+				return it->second.hash;
+			}
+		}
+		MappedFile file(font);
+		if (!file.is_open()) {
+			return std::nullopt;
+		}
+		u64 hash     = hash_bytes(file.bytes());
+		bool changed = false;
+		{
+			std::lock_guard lock(m_HashMutex);
+			auto [it, inserted] = m_FontHashes.try_emplace(path);
+			changed             = !inserted && it->second.hash != hash;
+			it->second          = FontHash{ .size = size, .mtime = mtime, .hash = hash };
+		}
+		if (changed) {
+			evict_faces(path); // Cached faces still hold the old font, they would bake it under the new key.
+		}
+		return hash;
 	}
 
-	void Library::cache_glyphs(const std::filesystem::path& cache_dir, const std::string& name, const FontData& data, const FontCfg& cfg) {
-		std::filesystem::path bin_cache_path = cache_path(cache_dir, name, ".bin", cfg);
+	std::optional<u64> Library::cache_key(const FontCfg& cfg, std::span<const char32_t> codepoints) {
+		// Everything that changes the baked bytes, the path does not so moved fonts keep their cache.
+		std::optional<u64> font = font_hash(cfg.path);
+		if (!font) {
+			return std::nullopt;
+		}
+		u64 key  = mix64(*font ^ s_CacheVersion);
+		auto add = [&key](u64 value) { key = mix64(key ^ value); };
+		add(s_Version.value); // Rasterizer and packer changes between releases.
+		add(bake_pt(cfg));
+		add(std::bit_cast<u32>(cfg.dpi.x));
+		add(std::bit_cast<u32>(cfg.dpi.y));
+		add(static_cast<u64>(cfg.format));
+		add(static_cast<u64>(cfg.render_mode));
+		add(cfg.render_mode == ERenderMode::SDF ? sdf_spread(cfg) : 0);
+		add(cfg.max_page_size);
+		add(cfg.padding);
+		add(cfg.uniform_pages);
+		add(static_cast<u64>(cfg.cache_layout)); // A bundle and the separate files of one config are two entries.
+		add(cfg.on_batch ? 1 : 0); // Streaming packs online, the pages differ.
+		add(codepoints.size());
+		for (char32_t c : codepoints) {
+			add(c);
+		}
+		return key;
+	}
 
-		Serializer serializer(SerializeOpts{ .file = bin_cache_path, .mode = ESerializeMode::WRITE });
-		serializer.write(s_Version.value);
-		serializer.write(data.glyphs.size());
-		serializer.write(data.text_height);
-		serializer.write(data.is_mono);
-		for (const auto& [character, glyph] : data.glyphs) {
-			serializer.write(character);
-			serializer.write(glyph.advance);
-			serializer.write(glyph.offset);
-			serializer.write(glyph.bearing.x);
-			serializer.write(glyph.bearing.y);
-			serializer.write(glyph.size.x);
-			serializer.write(glyph.size.y);
-			serializer.write(glyph.texcoords[0].x);
-			serializer.write(glyph.texcoords[0].y);
-			serializer.write(glyph.texcoords[1].x);
-			serializer.write(glyph.texcoords[1].y);
-			serializer.write(glyph.texcoords[2].x);
-			serializer.write(glyph.texcoords[2].y);
-			serializer.write(glyph.texcoords[3].x);
-			serializer.write(glyph.texcoords[3].y);
-			serializer.write(glyph.reserved);
-		}
-		serializer.save();
-	}
-
-	std::filesystem::path Library::cache_path(const std::filesystem::path& cache_dir, const std::string& name, const std::filesystem::path& ext, const FontCfg& cfg) {
-		auto dir = cache_dir / "Fonts";
-		if (!std::filesystem::exists(dir)) {
-			std::filesystem::create_directories(dir);
-		}
-		auto path = name + "_" + std::to_string(cfg.range.start) + "_" + std::to_string(cfg.range.end) + "_" + std::to_string(cfg.pt) + ext.string();
-
-		return dir / path;
+	std::filesystem::path Library::cache_path(const std::filesystem::path& cache_dir, const std::string& name, const std::filesystem::path& ext, u64 key) {
+		return cache_dir / "Fonts" / std::format("{}_{:016x}{}", name, key, ext.string());
 	}
 
 } // namespace aby::ft
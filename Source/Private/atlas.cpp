@@ -0,0 +1,62 @@
+#include "FT/atlas.h"
+
+#include <PrettyPrint/PrettyPrint.h>
+
+#include <ostream>
+
+namespace aby::ft {
+
+	bool write_raw_atlas(const std::filesystem::path& file, u32 width, u32 height, EAtlasFormat format, std::span<const unsigned char> pixels) {
+		RawAtlasHeader header{
+			.width     = width,
+			.height    = height,
+			.format    = format,
+			.row_pitch = width * texel_size(format),
+		};
+		FT_ASSERT(pixels.size() == std::size_t(header.row_pitch) * height, "Raw atlas pixel count does not match its size");
+
+		return write_atomically(file, [&](std::ostream& out) {
+			char padding[64] = {};
+			out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			out.write(padding, header.data_offset - sizeof(header));
+			out.write(reinterpret_cast<const char*>(pixels.data()), pixels.size());
+		});
+	}
+
+	MappedAtlas::MappedAtlas(const std::filesystem::path& file) :
+	    m_File(file) {
+		if (!m_File.is_open() || m_File.size() < sizeof(RawAtlasHeader)) {
+			return;
+		}
+		const auto* header = reinterpret_cast<const RawAtlasHeader*>(m_File.data());
+		if (header->magic != RAW_ATLAS_MAGIC || header->version != RAW_ATLAS_VERSION) {
+			FT_ERROR("Not a raw atlas file: {}", file.string());
+			return;
+		}
+		if (u64(header->row_pitch) < u64(header->width) * texel_size(header->format)) {
+			FT_ERROR("Raw atlas rows are shorter than its width: {}", file.string());
+			return;
+		}
+		// Divided instead of multiplied, a corrupt header cannot wrap the size check.
+		if (header->data_offset > m_File.size() || (header->height != 0 && header->row_pitch > (m_File.size() - header->data_offset) / header->height)) {
+			FT_ERROR("Raw atlas file is truncated: {}", file.string());
+			return;
+		}
+		m_Header = header;
+	}
+
+	bool MappedAtlas::is_open() const {
+		return m_Header != nullptr;
+	}
+
+	const RawAtlasHeader& MappedAtlas::header() const {
+		FT_ASSERT(m_Header, "Raw atlas is not open");
+		return *m_Header;
+	}
+
+	std::span<const std::byte> MappedAtlas::pixels() const {
+		if (!m_Header) return {};
+		return m_File.bytes().subspan(m_Header->data_offset, std::size_t(m_Header->row_pitch) * m_Header->height);
+	}
+
+} // namespace aby::ft
@@ -0,0 +1,144 @@
+#include "FT/cache_manifest.h"
+#include "FT/serializer.h"
+
+#include <PrettyPrint/PrettyPrint.h>
+
+#include <algorithm>
+
+namespace aby::ft {
+
+	namespace {
+
+		struct CacheManifestHeader {
+			u32 magic       = CACHE_MANIFEST_MAGIC;
+			u32 version     = CACHE_MANIFEST_VERSION;
+			u64 entry_count = 0;
+			u64 page_count  = 0; // Pages of every entry, stored after the entries.
+		};
+		static_assert(sizeof(CacheManifestHeader) == 24);
+
+		struct CacheManifestRecord {
+			u64 key             = 0;
+			u64 size            = 0;
+			u64 glyph_count     = 0;
+			u64 first_page      = 0; // Index of the entry's first page in the page table.
+			u32 page_count      = 0;
+			ECacheLayout layout = ECacheLayout::FILES;
+			u32 png             = 0;
+			u32 raw             = 0;
+		};
+		static_assert(sizeof(CacheManifestRecord) == 48);
+
+	} // namespace
+
+	bool CacheManifestEntry::covers(const FontCfg& cfg) const {
+		return layout == ECacheLayout::BUNDLE || ((png || !cfg.write_png) && (raw || !cfg.write_raw));
+	}
+
+	CacheManifest::CacheManifest(const std::filesystem::path& dir) :
+	    m_File(dir / "manifest.bin"), m_Entries(read(m_File)) {
+	}
+
+	std::optional<CacheManifestEntry> CacheManifest::find(u64 key) const {
+		if (auto it = m_Entries.find(key); it != m_Entries.end()) {
+			return it->second;
+		}
+		return std::nullopt;
+	}
+
+	void CacheManifest::insert(const CacheManifestEntry& entry) {
+		m_Entries.merge(read(m_File)); // Keeps ours where both have a key.
+		m_Entries[entry.key] = entry;
+		write();
+	}
+
+	void CacheManifest::erase(u64 key) {
+		m_Entries.merge(read(m_File));
+		m_Entries.erase(key);
+		write();
+	}
+
+	std::size_t CacheManifest::size() const {
+		return m_Entries.size();
+	}
+
+	const std::filesystem::path& CacheManifest::file() const {
+		return m_File;
+	}
+
+	std::unordered_map<u64, CacheManifestEntry> CacheManifest::read(const std::filesystem::path& file) {
+		std::unordered_map<u64, CacheManifestEntry> entries;
+		auto mapping = std::make_shared<MappedFile>(file);
+		if (!mapping->is_open()) {
+			return entries; // No manifest yet.
+		}
+		Serializer serializer(SerializeOpts{ .file = file, .mode = ESerializeMode::MAP, .mapping = mapping });
+		if (mapping->size() < sizeof(CacheManifestHeader)) {
+			FT_WARN("Cache manifest is truncated, rebuilding it: {}", file.string());
+			return entries;
+		}
+		const CacheManifestHeader& header = serializer.view<CacheManifestHeader>(1).front();
+		// Counts are bounded by the bytes left for them, a corrupt count cannot wrap the check.
+		u64 left = mapping->size() - sizeof(CacheManifestHeader);
+		if (header.magic != CACHE_MANIFEST_MAGIC || header.version != CACHE_MANIFEST_VERSION || header.entry_count > left / sizeof(CacheManifestRecord) ||
+		    header.page_count > (left - header.entry_count * sizeof(CacheManifestRecord)) / sizeof(CacheManifestPage))
+		{
+			FT_WARN("Cache manifest is stale or truncated, rebuilding it: {}", file.string());
+			return entries;
+		}
+		auto records = serializer.view<CacheManifestRecord>(header.entry_count);
+		auto pages   = serializer.view<CacheManifestPage>(header.page_count);
+		entries.reserve(records.size());
+		for (const CacheManifestRecord& record : records) {
+			if (record.first_page > pages.size() || record.page_count > pages.size() - record.first_page) {
+				FT_WARN("Cache manifest is corrupt, rebuilding it: {}", file.string());
+				return {};
+			}
+			entries.emplace(record.key, CacheManifestEntry{
+			    .key         = record.key,
+			    .size        = record.size,
+			    .glyph_count = record.glyph_count,
+			    .layout      = record.layout,
+			    .png         = record.png != 0,
+			    .raw         = record.raw != 0,
+			    .pages       = { pages.begin() + record.first_page, pages.begin() + record.first_page + record.page_count },
+			});
+		}
+		return entries;
+	}
+
+	void CacheManifest::write() {
+		// Sorted so the same set of entries always produces the same file.
+		std::vector<const CacheManifestEntry*> sorted;
+		sorted.reserve(m_Entries.size());
+		for (const auto& [key, entry] : m_Entries) {
+			sorted.push_back(&entry);
+		}
+		std::sort(sorted.begin(), sorted.end(), [](const CacheManifestEntry* a, const CacheManifestEntry* b) { return a->key < b->key; });
+
+		std::vector<CacheManifestRecord> records;
+		std::vector<CacheManifestPage> pages;
+		records.reserve(sorted.size());
+		for (const CacheManifestEntry* entry : sorted) {
+			records.push_back(CacheManifestRecord{
+			    .key         = entry->key,
+			    .size        = entry->size,
+			    .glyph_count = entry->glyph_count,
+			    .first_page  = pages.size(),
+			    .page_count  = static_cast<u32>(entry->pages.size()),
+			    .layout      = entry->layout,
+			    .png         = entry->png,
+			    .raw         = entry->raw,
+			});
+			pages.insert(pages.end(), entry->pages.begin(), entry->pages.end());
+		}
+
+		CacheManifestHeader header{ .entry_count = records.size(), .page_count = pages.size() };
+		Serializer serializer(SerializeOpts{ .file = m_File, .mode = ESerializeMode::WRITE });
+		serializer.write_span(std::span<const CacheManifestHeader>(&header, 1));
+		serializer.write_span(std::span<const CacheManifestRecord>(records));
+		serializer.write_span(std::span<const CacheManifestPage>(pages));
+		serializer.save(); // Temp file and rename, readers never see a partial manifest.
+	}
+
+} // namespace aby::ft
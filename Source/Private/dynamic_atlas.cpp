@@ -0,0 +1,246 @@
+#include "FT/dynamic_atlas.h"
+#include "FT/kernels.h"
+
+#include <freetype/freetype.h>
+#include <PrettyPrint/PrettyPrint.h>
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace aby::ft {
+
+	namespace {
+
+		FontCfg face_cfg(const DynamicAtlasCfg& cfg) {
+			return FontCfg{ .pt = cfg.pt, .dpi = cfg.dpi, .path = cfg.path };
+		}
+
+	} // namespace
+
+	std::unique_ptr<DynamicAtlas> Library::create_dynamic_atlas(const DynamicAtlasCfg& cfg) {
+		FT_Face face = acquire_face(face_cfg(cfg));
+		return std::unique_ptr<DynamicAtlas>(new DynamicAtlas(*this, face, cfg));
+	}
+
+	DynamicAtlas::DynamicAtlas(Library& lib, ::FT_FaceRec_* face, const DynamicAtlasCfg& cfg) :
+	    m_Library(lib), m_Face(face), m_Cfg(cfg) {
+		const auto& metrics = face->size->metrics;
+		m_TextHeight        = (static_cast<float>(metrics.ascender) - static_cast<float>(metrics.descender)) / 64.0f * 0.5f;
+		m_Pixels.assign(std::size_t(cfg.width) * cfg.height * texel_size(cfg.format), 0);
+	}
+
+	DynamicAtlas::~DynamicAtlas() {
+		m_Library.release_face(m_Face);
+	}
+
+	const Glyph* DynamicAtlas::get(char32_t c) {
+		if (auto it = m_Resident.find(c); it != m_Resident.end()) {
+			m_Lru.splice(m_Lru.begin(), m_Lru, it->second);
+			it->second->frame = m_Frame;
+			return &it->second->glyph;
+		}
+		if (m_Missing.contains(c)) {
+			return nullptr;
+		}
+
+		if (::FT_Get_Char_Index(m_Face, c) == 0 || ::FT_Load_Char(m_Face, c, FT_LOAD_RENDER | FT_LOAD_FORCE_AUTOHINT | FT_LOAD_TARGET_LIGHT)) {
+			m_Missing.insert(c);
+			return nullptr;
+		}
+		auto* glyph = m_Face->glyph;
+		auto* bmp   = &glyph->bitmap;
+		if (bmp->width > m_Cfg.width || bmp->rows > m_Cfg.height) {
+			FT_WARN("Glyph {} of {} ({}x{}) is larger than the dynamic atlas", static_cast<u32>(c), m_Cfg.path.string(), bmp->width, bmp->rows);
+			m_Missing.insert(c);
+			return nullptr;
+		}
+
+		Rect slot;
+		u32 shelf = 0;
+		if (!acquire_slot(bmp->width, bmp->rows, slot, shelf)) {
+			return nullptr;
+		}
+
+		Rect rect{ .x = slot.x, .y = slot.y, .w = slot.w - m_Cfg.padding, .h = slot.h - m_Cfg.padding };
+		clear(rect);
+		u32 texel = texel_size(m_Cfg.format);
+		unsigned char* dst = &m_Pixels[(std::size_t(rect.y) * m_Cfg.width + rect.x) * texel];
+		const unsigned char* src = top_row(bmp->buffer, bmp->pitch, bmp->rows);
+		if (m_Cfg.format == EAtlasFormat::R8) {
+			blit_rows(src, bmp->pitch, dst, m_Cfg.width, bmp->width, bmp->rows);
+		} else {
+			for (u32 row = 0; row < bmp->rows; ++row) {
+				expand_r8_rgba8(src + std::ptrdiff_t(row) * bmp->pitch, dst + std::size_t(row) * m_Cfg.width * 4, bmp->width);
+			}
+		}
+		m_Dirty.push_back(rect);
+
+		float tex_width  = static_cast<float>(m_Cfg.width);
+		float tex_height = static_cast<float>(m_Cfg.height);
+		vec4 uvs{
+			static_cast<float>(rect.x) / tex_width,
+			static_cast<float>(rect.y) / tex_height,
+			static_cast<float>(rect.x + bmp->width) / tex_width,
+			static_cast<float>(rect.y + bmp->rows) / tex_height,
+		};
+		m_Lru.push_front(Entry{
+		    .glyph = Glyph{
+		        .advance   = static_cast<u32>(glyph->advance.x >> 6u),
+		        .offset    = rect.y * m_Cfg.width + rect.x,
+		        .bearing   = { static_cast<float>(glyph->bitmap_left), static_cast<float>(glyph->bitmap_top) },
+		        .size      = { static_cast<float>(bmp->width), static_cast<float>(bmp->rows) },
+		        .texcoords = {
+		            { uvs.x, uvs.y }, // Top-left  (0)
+		            { uvs.z, uvs.y }, // Top-right (1)
+		            { uvs.z, uvs.w }, // Bottom-right (2)
+		            { uvs.x, uvs.w }  // Bottom-left  (3)
+		        },
+		        .codepoint = c,
+		    },
+		    .slot  = slot,
+		    .shelf = shelf,
+		    .frame = m_Frame,
+		});
+		m_Resident[c] = m_Lru.begin();
+		return &m_Lru.front().glyph;
+	}
+
+	void DynamicAtlas::next_frame() {
+		++m_Frame;
+	}
+
+	std::vector<Rect> DynamicAtlas::take_dirty() {
+		return std::exchange(m_Dirty, {});
+	}
+
+	bool DynamicAtlas::acquire_slot(u32 width, u32 height, Rect& slot, u32& shelf) {
+		// Trailing padding may hang over the edge of the atlas, so an empty atlas takes any glyph that is not larger.
+		u32 w = std::min((width + m_Cfg.padding + s_SlotStep - 1) / s_SlotStep * s_SlotStep, m_Cfg.width + m_Cfg.padding);
+		u32 h = std::min((height + m_Cfg.padding + s_SlotStep - 1) / s_SlotStep * s_SlotStep, m_Cfg.height + m_Cfg.padding);
+		if (place(w, h, slot, shelf)) {
+			return true;
+		}
+		// Full. Glyphs used this frame are at the front, everything behind the first of them may go.
+		auto evictable = [this](const Entry& entry) { return entry.frame != m_Frame; };
+		for (auto it = m_Lru.rbegin(); it != m_Lru.rend() && evictable(*it); ++it) {
+			if (m_Shelves[it->shelf].height == h && it->slot.w >= w) {
+				evict(std::next(it).base()); // The least recently used glyph whose slot fits.
+				return place(w, h, slot, shelf);
+			}
+		}
+		// No slot of this height class, free the least recently used glyphs until a shelf empties.
+		while (!m_Lru.empty() && evictable(m_Lru.back())) {
+			evict(std::prev(m_Lru.end()));
+			if (place(w, h, slot, shelf)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool DynamicAtlas::place(u32 width, u32 height, Rect& slot, u32& shelf) {
+		auto take = [&](u32 i, Rect rect) {
+			shelf = i;
+			slot  = rect;
+			++m_Shelves[i].live;
+			return true;
+		};
+		// A freed slot of this height class, the narrowest that fits. The rest of it stays free.
+		Shelf* best_shelf = nullptr;
+		std::size_t best  = 0;
+		for (auto& candidate : m_Shelves) {
+			if (candidate.height != height) continue;
+			for (std::size_t i = 0; i < candidate.free.size(); ++i) {
+				if (candidate.free[i].w >= width && (!best_shelf || candidate.free[i].w < best_shelf->free[best].w)) {
+					best_shelf = &candidate;
+					best       = i;
+				}
+			}
+		}
+		if (best_shelf) {
+			Rect rect = best_shelf->free[best];
+			if (rect.w > width) {
+				best_shelf->free[best] = Rect{ .x = rect.x + width, .y = rect.y, .w = rect.w - width, .h = rect.h };
+			} else {
+				best_shelf->free[best] = best_shelf->free.back();
+				best_shelf->free.pop_back();
+			}
+			return take(static_cast<u32>(best_shelf - m_Shelves.data()), Rect{ .x = rect.x, .y = rect.y, .w = width, .h = height });
+		}
+		// The unused tail of a shelf of this height class.
+		for (u32 i = 0; i < m_Shelves.size(); ++i) {
+			Shelf& candidate = m_Shelves[i];
+			if (candidate.height == height && candidate.cursor + width <= m_Cfg.width + m_Cfg.padding) {
+				candidate.cursor += width;
+				return take(i, Rect{ .x = candidate.cursor - width, .y = candidate.y, .w = width, .h = height });
+			}
+		}
+		// A new shelf below the others.
+		if (m_ShelfTop + height <= m_Cfg.height + m_Cfg.padding) {
+			m_Shelves.push_back(Shelf{ .y = m_ShelfTop, .height = height, .cursor = width });
+			m_ShelfTop += height;
+			return take(static_cast<u32>(m_Shelves.size() - 1), Rect{ .x = 0, .y = m_Shelves.back().y, .w = width, .h = height });
+		}
+		// The shortest empty shelf that is tall enough, it keeps its height for the glyphs that follow.
+		Shelf* empty = nullptr;
+		for (auto& candidate : m_Shelves) {
+			if (candidate.live == 0 && candidate.height >= height && (!empty || candidate.height < empty->height)) {
+				empty = &candidate;
+			}
+		}
+		if (empty) {
+			empty->cursor = width;
+			return take(static_cast<u32>(empty - m_Shelves.data()), Rect{ .x = 0, .y = empty->y, .w = width, .h = empty->height });
+		}
+		return false;
+	}
+
+	void DynamicAtlas::evict(Lru::iterator it) {
+		Shelf& shelf = m_Shelves[it->shelf];
+		shelf.free.push_back(it->slot);
+		if (--shelf.live == 0) {
+			shelf.free.clear(); // Whole again, no matter how its slots were split.
+			shelf.cursor = 0;
+		}
+		m_Resident.erase(it->glyph.codepoint);
+		m_Lru.erase(it);
+		while (!m_Shelves.empty() && m_Shelves.back().live == 0) {
+			m_ShelfTop = m_Shelves.back().y; // Rows below the last used shelf may take any height again.
+			m_Shelves.pop_back();
+		}
+	}
+
+	void DynamicAtlas::clear(const Rect& rect) {
+		u32 texel = texel_size(m_Cfg.format);
+		for (u32 row = 0; row < rect.h; ++row) {
+			auto* dst = &m_Pixels[(std::size_t(rect.y + row) * m_Cfg.width + rect.x) * texel];
+			std::memset(dst, 0, std::size_t(rect.w) * texel);
+		}
+	}
+
+	std::span<const unsigned char> DynamicAtlas::pixels() const {
+		return m_Pixels;
+	}
+
+	u32 DynamicAtlas::width() const {
+		return m_Cfg.width;
+	}
+
+	u32 DynamicAtlas::height() const {
+		return m_Cfg.height;
+	}
+
+	EAtlasFormat DynamicAtlas::format() const {
+		return m_Cfg.format;
+	}
+
+	float DynamicAtlas::text_height() const {
+		return m_TextHeight;
+	}
+
+	std::size_t DynamicAtlas::size() const {
+		return m_Lru.size();
+	}
+
+} // namespace aby::ft
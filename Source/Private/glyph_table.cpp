@@ -0,0 +1,155 @@
+#include "FT/abyft.h"
+
+#include <PrettyPrint/PrettyPrint.h>
+
+#include <algorithm>
+#include <bit>
+#include <numeric>
+
+namespace aby::ft {
+
+	DenseGlyphs::DenseGlyphs(std::span<const Glyph> sorted_records) {
+		if (sorted_records.empty()) return;
+		m_Start = sorted_records.front().codepoint;
+		m_Glyphs.assign(sorted_records.back().codepoint - m_Start + 1, Glyph{ .codepoint = INVALID_CODEPOINT });
+		for (const Glyph& glyph : sorted_records) {
+			std::size_t idx = static_cast<char32_t>(glyph.codepoint - m_Start);
+			if (idx < m_Glyphs.size()) { // Only out of order records fall outside, the cache rejects those.
+				m_Glyphs[idx] = glyph;
+			}
+		}
+	}
+
+	Coverage::Coverage(std::span<const CharRange> sorted_ranges) {
+		if (sorted_ranges.empty()) return;
+		m_Bits.assign((std::size_t(sorted_ranges.back().end) + 63) / 64, 0);
+		// Whole words at a time, warm loads rebuild this from the cached ranges.
+		for (CharRange range : sorted_ranges) {
+			if (range.end <= range.start) continue;
+			std::size_t first = range.start >> 6;
+			std::size_t last  = (range.end - 1) >> 6;
+			u64 head          = ~u64(0) << (range.start & 63);
+			u64 tail          = ~u64(0) >> (63 - ((range.end - 1) & 63));
+			if (last >= m_Bits.size()) continue; // Only out of order runs end past the last one, the cache rejects those.
+			if (first == last) {
+				m_Bits[first] |= head & tail;
+			} else {
+				m_Bits[first] |= head;
+				std::fill(m_Bits.begin() + first + 1, m_Bits.begin() + last, ~u64(0));
+				m_Bits[last] |= tail;
+			}
+			m_Count += range.end - range.start;
+		}
+	}
+
+	bool Coverage::valid(std::span<const CharRange> ranges) {
+		char32_t prev = 0;
+		for (CharRange range : ranges) {
+			if (range.start < prev || range.end <= range.start || range.end > MAX_CODEPOINT + 1) {
+				return false;
+			}
+			prev = range.end;
+		}
+		return true;
+	}
+
+	std::vector<CharRange> Coverage::ranges() const {
+		std::vector<CharRange> out;
+		for (std::size_t word = 0; word < m_Bits.size(); ++word) {
+			u64 bits = m_Bits[word];
+			while (bits) {
+				char32_t c = static_cast<char32_t>(word * 64 + std::countr_zero(bits));
+				if (!out.empty() && out.back().end == c) {
+					++out.back().end;
+				} else {
+					out.push_back(CharRange{ .start = c, .end = c + 1 });
+				}
+				bits &= bits - 1;
+			}
+		}
+		return out;
+	}
+
+	namespace {
+
+		constexpr u32 MAX_SEED = 1u << 16;
+
+		bool build_perfect_hash(std::span<const Glyph> records, u32 bucket_count, std::vector<u32>& seeds, std::vector<u32>& slots) {
+			u32 n = static_cast<u32>(records.size());
+			std::vector<std::vector<u32>> buckets(bucket_count);
+			for (u32 i = 0; i < n; ++i) {
+				buckets[reduce(static_cast<u32>(mix64(records[i].codepoint)), bucket_count)].push_back(i);
+			}
+
+			// Place the crowded buckets first while most slots are still free.
+			std::vector<u32> order(bucket_count);
+			std::iota(order.begin(), order.end(), 0u);
+			std::stable_sort(order.begin(), order.end(), [&](u32 a, u32 b) { return buckets[a].size() > buckets[b].size(); });
+
+			std::vector<bool> taken(n, false);
+			std::vector<u32> placed;
+			seeds.assign(bucket_count, 0);
+			slots.assign(n, 0);
+			for (u32 b : order) {
+				const auto& keys = buckets[b];
+				if (keys.empty()) break;
+
+				u32 seed = 1;
+				for (; seed < MAX_SEED; ++seed) {
+					placed.clear();
+					for (u32 idx : keys) {
+						u32 slot = reduce(static_cast<u32>(mix64(records[idx].codepoint ^ (u64(seed) << 32))), n);
+						if (taken[slot] || std::find(placed.begin(), placed.end(), slot) != placed.end()) break;
+						placed.push_back(slot);
+					}
+					if (placed.size() == keys.size()) break;
+				}
+				if (seed == MAX_SEED) {
+					return false;
+				}
+
+				seeds[b] = seed;
+				for (std::size_t i = 0; i < keys.size(); ++i) {
+					taken[placed[i]] = true;
+					slots[placed[i]] = keys[i];
+				}
+			}
+			return true;
+		}
+
+	} // namespace
+
+	PerfectGlyphHash::PerfectGlyphHash(std::span<const Glyph> sorted_records) :
+	    m_Records(sorted_records) {
+		if (sorted_records.empty()) return;
+
+		u32 n = static_cast<u32>(sorted_records.size());
+		std::vector<u32> seeds, slots;
+		u32 bucket_count = std::max(1u, n / 4);
+		while (!build_perfect_hash(sorted_records, bucket_count, seeds, slots)) {
+			bucket_count *= 2; // Smaller buckets are easier to place, at the cost of a larger seed table.
+		}
+
+		auto owned = std::make_shared<std::vector<u32>>();
+		owned->reserve(seeds.size() + slots.size());
+		owned->insert(owned->end(), seeds.begin(), seeds.end());
+		owned->insert(owned->end(), slots.begin(), slots.end());
+		m_Seeds = std::span<const u32>(*owned).first(seeds.size());
+		m_Slots = std::span<const u32>(*owned).subspan(seeds.size());
+		m_Owned = std::move(owned);
+	}
+
+	PerfectGlyphHash::PerfectGlyphHash(std::span<const Glyph> sorted_records, std::span<const u32> seeds, std::span<const u32> slots) :
+	    m_Records(sorted_records), m_Seeds(seeds), m_Slots(slots) {
+		FT_ASSERT(slots.size() == sorted_records.size(), "Perfect hash has {} slots for {} glyphs", slots.size(), sorted_records.size());
+		FT_ASSERT(!seeds.empty() || slots.empty(), "Perfect hash has no seeds");
+	}
+
+	bool PerfectGlyphHash::valid(std::size_t record_count, std::span<const u32> seeds, std::span<const u32> slots) {
+		if (slots.size() != record_count || (seeds.empty() && !slots.empty())) {
+			return false;
+		}
+		return std::all_of(slots.begin(), slots.end(), [&](u32 slot) { return slot < record_count; });
+	}
+
+} // namespace aby::ft
@@ -0,0 +1,177 @@
+#include "FT/kernels.h"
+
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#	define ABY_FT_X86 1
+#	include <immintrin.h>
+#	ifdef _MSC_VER
+#		include <intrin.h>
+#	endif
+#elif defined(__aarch64__) || defined(_M_ARM64) || (defined(__ARM_NEON) && defined(__arm__))
+#	define ABY_FT_NEON 1
+#	include <arm_neon.h>
+#endif
+
+// Kernels for wider instruction sets than the build targets are compiled per function, so one binary runs everywhere.
+#if defined(ABY_FT_X86) && (defined(__GNUC__) || defined(__clang__))
+#	define ABY_FT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#	define ABY_FT_TARGET_AVX2
+#endif
+
+namespace aby::ft {
+
+	namespace {
+
+		void expand_scalar(const unsigned char* src, unsigned char* dst, std::size_t count) {
+			for (std::size_t i = 0; i < count; ++i) {
+				dst[i * 4 + 0] = src[i];
+				dst[i * 4 + 1] = src[i];
+				dst[i * 4 + 2] = src[i];
+				dst[i * 4 + 3] = 0xff;
+			}
+		}
+
+#ifdef ABY_FT_X86
+		void expand_sse2(const unsigned char* src, unsigned char* dst, std::size_t count) {
+			const __m128i alpha = _mm_set1_epi32(static_cast<int>(0xff000000));
+			std::size_t i       = 0;
+			for (; i + 16 <= count; i += 16) {
+				__m128i v    = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+				__m128i lo   = _mm_unpacklo_epi8(v, v);  // v0 v0 v1 v1 ...
+				__m128i hi   = _mm_unpackhi_epi8(v, v);
+				__m128i out0 = _mm_or_si128(_mm_unpacklo_epi16(lo, lo), alpha); // v0 v0 v0 v0 -> v0 v0 v0 ff
+				__m128i out1 = _mm_or_si128(_mm_unpackhi_epi16(lo, lo), alpha);
+				__m128i out2 = _mm_or_si128(_mm_unpacklo_epi16(hi, hi), alpha);
+				__m128i out3 = _mm_or_si128(_mm_unpackhi_epi16(hi, hi), alpha);
+				auto* d      = reinterpret_cast<__m128i*>(dst + i * 4);
+				_mm_storeu_si128(d + 0, out0);
+				_mm_storeu_si128(d + 1, out1);
+				_mm_storeu_si128(d + 2, out2);
+				_mm_storeu_si128(d + 3, out3);
+			}
+			expand_scalar(src + i, dst + i * 4, count - i);
+		}
+
+		ABY_FT_TARGET_AVX2 void expand_avx2(const unsigned char* src, unsigned char* dst, std::size_t count) {
+			// Broadcast each byte to its 4 byte texel with one shuffle per 8 texels, then force alpha.
+			const __m256i shuffle = _mm256_setr_epi8(
+			    0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3,
+			    4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7);
+			const __m256i alpha = _mm256_set1_epi32(static_cast<int>(0xff000000));
+			std::size_t i       = 0;
+			for (; i + 8 <= count; i += 8) {
+				// Both lanes get the same 8 bytes, the low lane expands the first 4 and the high lane the last 4.
+				__m256i v = _mm256_broadcastsi128_si256(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)));
+				_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i * 4), _mm256_or_si256(_mm256_shuffle_epi8(v, shuffle), alpha));
+			}
+			expand_scalar(src + i, dst + i * 4, count - i);
+		}
+
+		bool cpu_has_avx2() {
+#	if defined(__GNUC__) || defined(__clang__)
+			return __builtin_cpu_supports("avx2");
+#	elif defined(_MSC_VER)
+			int info[4];
+			__cpuid(info, 0);
+			if (info[0] < 7) return false;
+			__cpuidex(info, 1, 0);
+			bool os_saves_ymm = (info[2] & (1 << 27)) && (_xgetbv(0) & 0x6) == 0x6; // OSXSAVE, then XMM and YMM state.
+			__cpuidex(info, 7, 0);
+			return os_saves_ymm && (info[1] & (1 << 5));
+#	else
+			return false;
+#	endif
+		}
+#endif
+
+#ifdef ABY_FT_NEON
+		void expand_neon(const unsigned char* src, unsigned char* dst, std::size_t count) {
+			const uint8x16_t alpha = vdupq_n_u8(0xff);
+			std::size_t i          = 0;
+			for (; i + 16 <= count; i += 16) {
+				uint8x16_t v = vld1q_u8(src + i);
+				vst4q_u8(dst + i * 4, uint8x16x4_t{ { v, v, v, alpha } }); // Interleaving store does the expansion.
+			}
+			expand_scalar(src + i, dst + i * 4, count - i);
+		}
+#endif
+
+		EKernelIsa detect_isa() {
+#if defined(ABY_FT_X86)
+			return cpu_has_avx2() ? EKernelIsa::AVX2 : EKernelIsa::SSE2; // SSE2 is part of x86-64.
+#elif defined(ABY_FT_NEON)
+			return EKernelIsa::NEON;
+#else
+			return EKernelIsa::SCALAR;
+#endif
+		}
+
+	} // namespace
+
+	EKernelIsa kernel_isa() {
+		static const EKernelIsa isa = detect_isa();
+		return isa;
+	}
+
+	bool kernel_supported(EKernelIsa isa) {
+		switch (isa) {
+			case EKernelIsa::SCALAR: return true;
+			case EKernelIsa::SSE2: return kernel_isa() == EKernelIsa::SSE2 || kernel_isa() == EKernelIsa::AVX2;
+			case EKernelIsa::AVX2: return kernel_isa() == EKernelIsa::AVX2;
+			case EKernelIsa::NEON: return kernel_isa() == EKernelIsa::NEON;
+		}
+		return false;
+	}
+
+	const char* kernel_isa_name(EKernelIsa isa) {
+		switch (isa) {
+			case EKernelIsa::SCALAR: return "scalar";
+			case EKernelIsa::SSE2: return "sse2";
+			case EKernelIsa::AVX2: return "avx2";
+			case EKernelIsa::NEON: return "neon";
+		}
+		return "unknown";
+	}
+
+	void blit_rows(const unsigned char* src, std::ptrdiff_t src_pitch, unsigned char* dst, std::ptrdiff_t dst_pitch, std::size_t row_bytes, u32 rows) {
+		if (rows == 0 || row_bytes == 0) {
+			return; // Empty glyphs (space) have no buffer, memcpy must not see their null pointer.
+		}
+		auto contiguous = static_cast<std::ptrdiff_t>(row_bytes);
+		if (src_pitch == contiguous && dst_pitch == contiguous) {
+			std::memcpy(dst, src, row_bytes * rows); // Contiguous, one copy.
+			return;
+		}
+		// memcpy is already vectorized for the target by the C library, rows are too short for anything else to pay off.
+		for (u32 row = 0; row < rows; ++row) {
+			std::memcpy(dst + std::ptrdiff_t(row) * dst_pitch, src + std::ptrdiff_t(row) * src_pitch, row_bytes);
+		}
+	}
+
+	const unsigned char* top_row(const unsigned char* buffer, std::ptrdiff_t pitch, u32 rows) {
+		if (pitch >= 0 || rows == 0) {
+			return buffer;
+		}
+		return buffer - pitch * std::ptrdiff_t(rows - 1);
+	}
+
+	void expand_r8_rgba8(const unsigned char* src, unsigned char* dst, std::size_t count) {
+		expand_r8_rgba8(src, dst, count, kernel_isa());
+	}
+
+	void expand_r8_rgba8(const unsigned char* src, unsigned char* dst, std::size_t count, EKernelIsa isa) {
+		switch (isa) {
+#ifdef ABY_FT_X86
+			case EKernelIsa::AVX2: expand_avx2(src, dst, count); return;
+			case EKernelIsa::SSE2: expand_sse2(src, dst, count); return;
+#endif
+#ifdef ABY_FT_NEON
+			case EKernelIsa::NEON: expand_neon(src, dst, count); return;
+#endif
+			default: expand_scalar(src, dst, count); return;
+		}
+	}
+
+} // namespace aby::ft
@@ -13,7 +13,11 @@ namespace aby::util {
 		std::string pt        = "12";
 		std::string dpi       = "96,96";
 		std::string range     = "32,128";
+		std::string charset   = "";
+		std::string format    = "rgba8";
 		bool verbose          = false;
+		bool no_png           = false;
+		bool bundle           = false;
 		std::string cache_dir = ".";
 	};
 
@@ -43,25 +47,56 @@ namespace aby::util {
 			parse_errors += std::format("  Failed to parse 'dpi'. ({}). {}.\n", in_cfg.dpi, e.what());
 		}
 
-		// Parse character range
+		// Parse character ranges, the first one replaces the default range
 		try {
-			std::stringstream ss(in_cfg.range);
-			std::string token;
-			uint32_t vals[2] = { 32, 128 };
-			int i            = 0;
-			while (std::getline(ss, token, ',') && i < 2) {
-				vals[i++] = static_cast<uint32_t>(std::stoul(token));
-			}
-			if (i != 2) {
-				parse_errors += std::format("  Character range must contain two comma-separated integers (e.g. \"32,128\"). Got: ({}).\n", in_cfg.range);
+			std::stringstream ranges(in_cfg.range);
+			std::string range;
+			bool first = true;
+			while (std::getline(ranges, range, ';')) {
+				std::stringstream ss(range);
+				std::string token;
+				uint32_t vals[2] = { 32, 128 };
+				int i            = 0;
+				while (std::getline(ss, token, ',') && i < 2) {
+					vals[i++] = static_cast<uint32_t>(std::stoul(token));
+				}
+				if (i != 2) {
+					parse_errors += std::format("  Character ranges must contain two comma-separated integers each, separated by ';' (e.g. \"32,128;1024,1280\"). Got: ({}).\n", in_cfg.range);
+					break;
+				}
+				aby::ft::CharRange r = { static_cast<char32_t>(vals[0]), static_cast<char32_t>(vals[1]) };
+				if (first) {
+					out_cfg.range = r;
+					first         = false;
+				} else {
+					out_cfg.ranges.push_back(r);
+				}
 			}
-			out_cfg.range = { static_cast<char32_t>(vals[0]), static_cast<char32_t>(vals[1]) };
 		} catch (const std::exception& e) {
 			parse_errors += std::format("  Failed to parse 'range'. ({}). {}.\n", in_cfg.range, e.what());
 		}
 
-		out_cfg.verbose = in_cfg.verbose;
-		out_cfg.path    = in_cfg.file;
+		if (!in_cfg.charset.empty()) {
+			if (std::filesystem::exists(in_cfg.charset)) {
+				out_cfg.charset = in_cfg.charset;
+			} else {
+				parse_errors += std::format("  Charset file does not exist: ({}).\n", in_cfg.charset);
+			}
+		}
+
+		// Parse atlas format
+		if (in_cfg.format == "rgba8") {
+			out_cfg.format = aby::ft::EAtlasFormat::RGBA8;
+		} else if (in_cfg.format == "r8") {
+			out_cfg.format = aby::ft::EAtlasFormat::R8;
+		} else {
+			parse_errors += std::format("  Atlas format must be one of \"rgba8\" or \"r8\". Got: ({}).\n", in_cfg.format);
+		}
+
+		out_cfg.write_png    = !in_cfg.no_png;
+		out_cfg.cache_layout = in_cfg.bundle ? aby::ft::ECacheLayout::BUNDLE : aby::ft::ECacheLayout::FILES;
+		out_cfg.verbose      = in_cfg.verbose;
+		out_cfg.path         = in_cfg.file;
 
 		if (!parse_errors.empty()) {
 			pretty_print(parse_errors, "Errors", Colors{ .box = EColor::RED, .ctx = EColor::YELLOW });
@@ -90,9 +125,13 @@ int main(int argc, char** argv) {
 	if (!cmd.opt("file", "Font file to load", &in_cfg.file, true)
 	         .opt("pt", "Requested point size of font (Default: '12')", &in_cfg.pt)
 	         .opt("dpi", "Dots per inch (Default: '96,96')", &in_cfg.dpi)
-	         .opt("range", "Character range to load (Default: '32,128')", &in_cfg.range)
+	         .opt("range", "Character ranges to load, ';' separated (Default: '32,128')", &in_cfg.range)
+	         .opt("charset", "UTF-8 text file, every character in it is loaded as well", &in_cfg.charset)
+	         .opt("format", "Atlas texel format, 'rgba8' or 'r8' (Default: 'rgba8')", &in_cfg.format)
 	         .opt("cache_dir", "Directory to output cached png and binary glyph to (Default '.')", &in_cfg.cache_dir)
 	         .flag("version", "Display version number and build info", &version, false, { "file" })
+	         .flag("no_png", "Only output the raw atlas, skip png encoding", &in_cfg.no_png)
+	         .flag("bundle", "Cache glyphs and atlas pages in a single .abft file", &in_cfg.bundle)
 	         .flag("v", "Enable verbose log messages", &in_cfg.verbose)
 	         .flag("q", "Suppress output log messages", &quiet)
 	         .parse(argc, argv, opts) ||
@@ -129,10 +168,24 @@ int main(int argc, char** argv) {
 		load_info += std::format("    \033[36mGlyphs:      \033[0m\033[30m{}\033[0m\n", data.glyphs.size());
 		load_info += std::format("    \033[36mMonospaced:  \033[0m\033[30m{}\033[0m\n", data.is_mono);
 		load_info += std::format("    \033[36mText Height: \033[0m\033[30m{}\033[0m\n", data.text_height);
-		load_info += std::format("    \033[36mOutput PNG:  \033[0m\033[4m\033[34m{}\033[0m\n", std::filesystem::absolute(data.png).string());
+		for (const auto& page : data.pages) {
+			if (!page.png.empty()) {
+				load_info += std::format("    \033[36mOutput PNG:  \033[0m\033[4m\033[34m{}\033[0m ({}x{})\n", std::filesystem::absolute(page.png).string(), page.width, page.height);
+			}
+			if (!page.raw.empty()) {
+				load_info += std::format("    \033[36mOutput Raw:  \033[0m\033[4m\033[34m{}\033[0m ({}x{})\n", std::filesystem::absolute(page.raw).string(), page.width, page.height);
+			}
+		}
+		load_info += std::format("    \033[36mFormat:      \033[0m\033[30m{}\033[0m\n", data.format == aby::ft::EAtlasFormat::R8 ? "r8" : "rgba8");
 		load_info += std::format("    \033[36mPoint Size:  \033[0m\033[30m{}\033[0m\n", out_cfg.pt);
 		load_info += std::format("    \033[36mDPI:         \033[0m\033[30m({}, {})\033[0m\n", out_cfg.dpi.x, out_cfg.dpi.y);
 		load_info += std::format("    \033[36mChar Range:  \033[0m\033[30m({}, {})\033[0m\n", static_cast<uint32_t>(out_cfg.range.start), static_cast<uint32_t>(out_cfg.range.end));
+		for (const auto& range : out_cfg.ranges) {
+			load_info += std::format("    \033[36mChar Range:  \033[0m\033[30m({}, {})\033[0m\n", static_cast<uint32_t>(range.start), static_cast<uint32_t>(range.end));
+		}
+		if (!out_cfg.charset.empty()) {
+			load_info += std::format("    \033[36mCharset:     \033[0m\033[4m\033[34m{}\033[0m\n", out_cfg.charset.string());
+		}
 
 		aby::util::pretty_print(load_info, "AbyssFreetype", aby::util::Colors{ .box = aby::util::EColor::GREEN, .ctx = aby::util::EColor::YELLOW });
 	}
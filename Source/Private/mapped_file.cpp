@@ -0,0 +1,161 @@
+#include "FT/mapped_file.h"
+
+#ifdef _WIN32
+#	ifndef NOMINMAX
+#		define NOMINMAX
+#	endif
+#	ifndef WIN32_LEAN_AND_MEAN
+#		define WIN32_LEAN_AND_MEAN
+#	endif
+#	include <windows.h>
+#else
+#	include <cerrno>
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+#include <atomic>
+#include <fstream>
+#include <random>
+#include <utility>
+
+namespace aby::ft {
+
+	std::filesystem::path temp_path(const std::filesystem::path& file) {
+		static const u64 s_Process = std::random_device{}(); // Other processes may share the cache directory.
+		static std::atomic<u64> s_Next = 0;
+		auto tmp = file;
+		tmp     += std::format(".{:x}_{}.tmp", s_Process, s_Next.fetch_add(1));
+		return tmp;
+	}
+
+	bool write_atomically(const std::filesystem::path& file, const std::function<void(std::ostream&)>& writer) {
+		// Renaming keeps mappings of the previous file valid, readers see it or the new one, never a partial file.
+		auto tmp = temp_path(file);
+		std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+		if (!ofs.is_open()) {
+			FT_ERROR("Failed to open file for writing: {}", tmp.string());
+			return false;
+		}
+		writer(ofs);
+		ofs.close();
+		std::error_code ec;
+		if (!ofs) {
+			FT_ERROR("Failed to write file: {}", tmp.string());
+			std::filesystem::remove(tmp, ec);
+			return false;
+		}
+
+		std::filesystem::rename(tmp, file, ec);
+		if (ec) {
+			FT_ERROR("Failed to replace file: {} ({})", file.string(), ec.message());
+			std::filesystem::remove(tmp, ec);
+			return false;
+		}
+		return true;
+	}
+
+	MappedFile::MappedFile(const std::filesystem::path& file) {
+#ifdef _WIN32
+		// Mappings live as long as cached faces and FontData, sharing delete lets font and cache files be replaced meanwhile.
+		HANDLE handle = ::CreateFileW(file.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (handle == INVALID_HANDLE_VALUE) {
+			DWORD error = ::GetLastError();
+			if (error != ERROR_FILE_NOT_FOUND && error != ERROR_PATH_NOT_FOUND) { // Missing files are how callers probe caches.
+				FT_ERROR("Failed to open file for mapping: {}", file.string());
+			}
+			return;
+		}
+		LARGE_INTEGER size;
+		if (!::GetFileSizeEx(handle, &size) || size.QuadPart == 0) {
+			::CloseHandle(handle);
+			return;
+		}
+		HANDLE mapping = ::CreateFileMappingW(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!mapping) {
+			FT_ERROR("Failed to map file: {}", file.string());
+			::CloseHandle(handle);
+			return;
+		}
+		m_File    = handle;
+		m_Mapping = mapping;
+		m_Data    = static_cast<const std::byte*>(::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		m_Size    = m_Data ? static_cast<std::size_t>(size.QuadPart) : 0;
+#else
+		int fd = ::open(file.c_str(), O_RDONLY);
+		if (fd < 0) {
+			if (errno != ENOENT) { // Missing files are how callers probe caches.
+				FT_ERROR("Failed to open file for mapping: {}", file.string());
+			}
+			return;
+		}
+		struct stat st;
+		if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+			::close(fd);
+			return;
+		}
+		void* data = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (data == MAP_FAILED) {
+			FT_ERROR("Failed to map file: {}", file.string());
+			return;
+		}
+		m_Data = static_cast<const std::byte*>(data);
+		m_Size = static_cast<std::size_t>(st.st_size);
+#endif
+	}
+
+	MappedFile::~MappedFile() {
+		close();
+	}
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept {
+		*this = std::move(other);
+	}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+		if (this != &other) {
+			close();
+			m_Data = std::exchange(other.m_Data, nullptr);
+			m_Size = std::exchange(other.m_Size, 0);
+#ifdef _WIN32
+			m_File    = std::exchange(other.m_File, nullptr);
+			m_Mapping = std::exchange(other.m_Mapping, nullptr);
+#endif
+		}
+		return *this;
+	}
+
+	bool MappedFile::is_open() const {
+		return m_Data != nullptr;
+	}
+
+	const std::byte* MappedFile::data() const {
+		return m_Data;
+	}
+
+	std::size_t MappedFile::size() const {
+		return m_Size;
+	}
+
+	std::span<const std::byte> MappedFile::bytes() const {
+		return { m_Data, m_Size };
+	}
+
+	void MappedFile::close() {
+#ifdef _WIN32
+		if (m_Data) ::UnmapViewOfFile(m_Data);
+		if (m_Mapping) ::CloseHandle(m_Mapping);
+		if (m_File) ::CloseHandle(m_File);
+		m_File    = nullptr;
+		m_Mapping = nullptr;
+#else
+		if (m_Data) ::munmap(const_cast<std::byte*>(m_Data), m_Size);
+#endif
+		m_Data = nullptr;
+		m_Size = 0;
+	}
+
+} // namespace aby::ft
@@ -0,0 +1,236 @@
+#include "FT/packer.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace aby::ft {
+
+	SkylinePacker::SkylinePacker(u32 width, u32 height) {
+		reset(width, height);
+	}
+
+	void SkylinePacker::reset(u32 width, u32 height) {
+		m_Width  = width;
+		m_Height = height;
+		m_Skyline.clear();
+		m_Skyline.push_back(Node{ .x = 0, .y = 0, .w = width });
+	}
+
+	u32 SkylinePacker::width() const {
+		return m_Width;
+	}
+
+	u32 SkylinePacker::height() const {
+		return m_Height;
+	}
+
+	bool SkylinePacker::fits(std::size_t idx, u32 w, u32 h, u32& y) const {
+		if (m_Skyline[idx].x + w > m_Width) {
+			return false;
+		}
+		i64 width_left = w;
+		y              = m_Skyline[idx].y;
+		while (width_left > 0) {
+			y = std::max(y, m_Skyline[idx].y);
+			if (y + h > m_Height) {
+				return false;
+			}
+			width_left -= m_Skyline[idx].w;
+			++idx;
+		}
+		return true;
+	}
+
+	bool SkylinePacker::pack(u32 w, u32 h, Rect& out) {
+		std::size_t best_idx = m_Skyline.size();
+		u32 best_y           = std::numeric_limits<u32>::max();
+		u32 best_w           = std::numeric_limits<u32>::max();
+		for (std::size_t i = 0; i < m_Skyline.size(); ++i) {
+			u32 y = 0;
+			if (!fits(i, w, h, y)) continue;
+			if (y + h < best_y || (y + h == best_y && m_Skyline[i].w < best_w)) {
+				best_idx = i;
+				best_y   = y + h;
+				best_w   = m_Skyline[i].w;
+			}
+		}
+		if (best_idx == m_Skyline.size()) {
+			return false;
+		}
+
+		out = Rect{ .x = m_Skyline[best_idx].x, .y = best_y - h, .w = w, .h = h };
+
+		// Raise the skyline under the new rect, then trim the nodes it covers.
+		m_Skyline.insert(m_Skyline.begin() + best_idx, Node{ .x = out.x, .y = best_y, .w = w });
+		for (std::size_t i = best_idx + 1; i < m_Skyline.size();) {
+			Node& prev = m_Skyline[i - 1];
+			Node& node = m_Skyline[i];
+			if (node.x >= prev.x + prev.w) break;
+			u32 shrink = prev.x + prev.w - node.x;
+			if (node.w > shrink) {
+				node.x += shrink;
+				node.w -= shrink;
+				break;
+			}
+			m_Skyline.erase(m_Skyline.begin() + i);
+		}
+
+		for (std::size_t i = 0; i + 1 < m_Skyline.size();) {
+			if (m_Skyline[i].y == m_Skyline[i + 1].y) {
+				m_Skyline[i].w += m_Skyline[i + 1].w;
+				m_Skyline.erase(m_Skyline.begin() + i + 1);
+			} else {
+				++i;
+			}
+		}
+		return true;
+	}
+
+	OnlineAtlasPacker::OnlineAtlasPacker(u32 page_size, u32 padding) :
+	    m_Packer(page_size + padding, page_size + padding), m_PageSize(page_size), m_Padding(padding) {
+	}
+
+	bool OnlineAtlasPacker::place(u32 w, u32 h, Rect& rect, u32& page) {
+		if (w > m_PageSize || h > m_PageSize) {
+			return false;
+		}
+		if (m_PageCount == 0) {
+			m_PageCount = 1;
+		}
+		if (w == 0 || h == 0) {
+			rect = Rect{ .x = 0, .y = 0, .w = w, .h = h };
+			page = m_PageCount - 1;
+			return true;
+		}
+		// Same extra padding column/row as layout_atlas, so the last rect may touch the border.
+		if (!m_Packer.pack(w + m_Padding, h + m_Padding, rect)) {
+			m_Packer.reset(m_PageSize + m_Padding, m_PageSize + m_Padding);
+			++m_PageCount;
+			m_Packer.pack(w + m_Padding, h + m_Padding, rect);
+		}
+		rect.w = w;
+		rect.h = h;
+		page   = m_PageCount - 1;
+		return true;
+	}
+
+	u32 OnlineAtlasPacker::page_count() const {
+		return m_PageCount;
+	}
+
+	u32 OnlineAtlasPacker::page_size() const {
+		return m_PageSize;
+	}
+
+	namespace {
+
+		bool empty(const Rect& size) {
+			return size.w == 0 || size.h == 0;
+		}
+
+		bool pack_page(std::span<const Rect> sizes, std::span<const std::size_t> order, u32 w, u32 h, u32 padding, std::vector<Rect>& rects) {
+			// The packer gets one extra padding column/row so the last rect may touch the border.
+			SkylinePacker packer(w + padding, h + padding);
+			for (std::size_t idx : order) {
+				const Rect& size = sizes[idx];
+				Rect& rect       = rects[idx];
+				if (empty(size)) {
+					rect = Rect{ .x = 0, .y = 0, .w = size.w, .h = size.h };
+					continue;
+				}
+				if (!packer.pack(size.w + padding, size.h + padding, rect)) {
+					return false;
+				}
+				rect.w = size.w;
+				rect.h = size.h;
+			}
+			return true;
+		}
+
+		bool fit_page(std::span<const Rect> sizes, std::span<const std::size_t> order, u32 max_size, u32 padding, AtlasLayout::Page& page, std::vector<Rect>& rects) {
+			u64 area  = 0;
+			u32 max_w = 0;
+			u32 max_h = 0;
+			for (std::size_t idx : order) {
+				const Rect& size = sizes[idx];
+				if (empty(size)) continue;
+				area  += u64(size.w + padding) * u64(size.h + padding);
+				max_w  = std::max(max_w, size.w);
+				max_h  = std::max(max_h, size.h);
+			}
+
+			// u64 so doubling past 2^31 ends the loop instead of wrapping to 0.
+			for (u64 h = 1; h <= max_size; h <<= 1) {
+				for (u64 w : { h, h << 1 }) {
+					if (w > max_size || (w + padding) * (h + padding) < area || w < max_w || h < max_h) continue;
+					if (pack_page(sizes, order, static_cast<u32>(w), static_cast<u32>(h), padding, rects)) {
+						page = AtlasLayout::Page{ .width = static_cast<u32>(w), .height = static_cast<u32>(h) };
+						return true;
+					}
+				}
+			}
+
+			// max_size need not be a power of two, the first pass already fit these rects at full size.
+			if (pack_page(sizes, order, max_size, max_size, padding, rects)) {
+				page = AtlasLayout::Page{ .width = max_size, .height = max_size };
+				return true;
+			}
+			return false;
+		}
+
+	} // namespace
+
+	bool layout_atlas(std::span<const Rect> sizes, u32 max_size, u32 padding, bool uniform, AtlasLayout& out) {
+		std::vector<std::size_t> order(sizes.size());
+		std::iota(order.begin(), order.end(), std::size_t(0));
+		std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+			if (sizes[a].h != sizes[b].h) return sizes[a].h > sizes[b].h;
+			return sizes[a].w > sizes[b].w;
+		});
+
+		out.pages.clear();
+		out.rects.assign(sizes.size(), Rect{});
+		out.page.assign(sizes.size(), 0);
+
+		// Fill full size pages first, anything that does not fit spills over to the next page.
+		std::vector<std::vector<std::size_t>> page_orders;
+		SkylinePacker packer(max_size + padding, max_size + padding);
+		for (std::size_t idx : order) {
+			const Rect& size = sizes[idx];
+			if (size.w > max_size || size.h > max_size) {
+				return false;
+			}
+			Rect rect;
+			if (page_orders.empty() || (!empty(size) && !packer.pack(size.w + padding, size.h + padding, rect))) {
+				packer.reset(max_size + padding, max_size + padding);
+				page_orders.emplace_back();
+				if (!empty(size)) packer.pack(size.w + padding, size.h + padding, rect);
+			}
+			page_orders.back().push_back(idx);
+		}
+
+		// Then shrink every page to the smallest size that still holds its rects.
+		for (u32 i = 0; i < page_orders.size(); ++i) {
+			AtlasLayout::Page page;
+			if (!fit_page(sizes, page_orders[i], max_size, padding, page, out.rects)) {
+				return false;
+			}
+			for (std::size_t idx : page_orders[i]) {
+				out.page[idx] = i;
+			}
+			out.pages.push_back(page);
+		}
+
+		if (uniform) {
+			AtlasLayout::Page largest;
+			for (const auto& page : out.pages) {
+				largest.width  = std::max(largest.width, page.width);
+				largest.height = std::max(largest.height, page.height);
+			}
+			std::fill(out.pages.begin(), out.pages.end(), largest);
+		}
+		return true;
+	}
+
+} // namespace aby::ft
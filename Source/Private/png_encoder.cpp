@@ -0,0 +1,226 @@
+#include "FT/png_encoder.h"
+#include "FT/mapped_file.h"
+#include "FT/thread_pool.h"
+
+#include <PrettyPrint/PrettyPrint.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <ostream>
+#include <thread>
+
+namespace aby::ft {
+
+	namespace {
+
+		constexpr std::array<unsigned char, 8> PNG_SIGNATURE = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+		constexpr std::size_t DEFLATE_WINDOW                 = 32768;
+		constexpr std::size_t MAX_IDAT                       = std::size_t(1) << 30;
+
+		unsigned char paeth(unsigned char a, unsigned char b, unsigned char c) {
+			int p  = int(a) + int(b) - int(c);
+			int pa = std::abs(p - int(a));
+			int pb = std::abs(p - int(b));
+			int pc = std::abs(p - int(c));
+			if (pa <= pb && pa <= pc) return a;
+			if (pb <= pc) return b;
+			return c;
+		}
+
+		// Writes the filter type byte followed by the filtered row. prev is nullptr for the first row.
+		void filter_row(EPngFilter filter, const unsigned char* row, const unsigned char* prev, std::size_t length, u32 bpp, unsigned char* out) {
+			out[0] = static_cast<unsigned char>(filter);
+			unsigned char* dst = out + 1;
+			for (std::size_t i = 0; i < length; ++i) {
+				unsigned char left     = i >= bpp ? row[i - bpp] : 0;
+				unsigned char up       = prev ? prev[i] : 0;
+				unsigned char up_left  = prev && i >= bpp ? prev[i - bpp] : 0;
+				unsigned char predict  = 0;
+				switch (filter) {
+					case EPngFilter::SUB:     predict = left; break;
+					case EPngFilter::UP:      predict = up; break;
+					case EPngFilter::AVERAGE: predict = static_cast<unsigned char>((u32(left) + up) / 2); break;
+					case EPngFilter::PAETH:   predict = paeth(left, up, up_left); break;
+					default:                  break;
+				}
+				dst[i] = static_cast<unsigned char>(row[i] - predict);
+			}
+		}
+
+		u64 residual_cost(const unsigned char* filtered, std::size_t length) {
+			u64 cost = 0;
+			for (std::size_t i = 0; i < length; ++i) {
+				cost += static_cast<u64>(std::abs(static_cast<int>(static_cast<signed char>(filtered[i]))));
+			}
+			return cost;
+		}
+
+		int zlib_strategy(EPngStrategy strategy) {
+			switch (strategy) {
+				case EPngStrategy::FILTERED:     return Z_FILTERED;
+				case EPngStrategy::HUFFMAN_ONLY: return Z_HUFFMAN_ONLY;
+				case EPngStrategy::RLE:          return Z_RLE;
+				default:                         return Z_DEFAULT_STRATEGY;
+			}
+		}
+
+		void put_u32(std::vector<unsigned char>& out, u32 value) {
+			out.push_back(static_cast<unsigned char>(value >> 24));
+			out.push_back(static_cast<unsigned char>(value >> 16));
+			out.push_back(static_cast<unsigned char>(value >> 8));
+			out.push_back(static_cast<unsigned char>(value));
+		}
+
+		void put_chunk(std::vector<unsigned char>& out, const char (&type)[5], std::span<const unsigned char> data) {
+			put_u32(out, static_cast<u32>(data.size()));
+			out.insert(out.end(), type, type + 4);
+			out.insert(out.end(), data.begin(), data.end());
+			uLong crc = ::crc32(0L, reinterpret_cast<const Bytef*>(type), 4);
+			if (!data.empty()) {
+				crc = ::crc32(crc, data.data(), static_cast<uInt>(data.size())); // A null buffer would reset it.
+			}
+			put_u32(out, static_cast<u32>(crc));
+		}
+
+		struct Band {
+			std::size_t begin = 0; // Offset into the filtered rows.
+			std::size_t size  = 0;
+			std::vector<unsigned char> deflated;
+			uLong adler = 0;
+			bool ok     = false;
+		};
+
+		// Raw deflate of one band. Every band but the last ends on a byte boundary (sync flush) without
+		// the final bit, so the bands concatenate into a single valid stream.
+		void deflate_band(const std::vector<unsigned char>& filtered, Band& band, bool last, int level, int strategy) {
+			z_stream zs{};
+			if (::deflateInit2(&zs, level, Z_DEFLATED, -15, 8, strategy) != Z_OK) {
+				return;
+			}
+			if (band.begin > 0) {
+				std::size_t dict = std::min(band.begin, DEFLATE_WINDOW);
+				::deflateSetDictionary(&zs, &filtered[band.begin - dict], static_cast<uInt>(dict));
+			}
+			band.deflated.resize(::deflateBound(&zs, static_cast<uLong>(band.size)) + 16);
+			zs.next_in   = const_cast<Bytef*>(&filtered[band.begin]);
+			zs.avail_in  = static_cast<uInt>(band.size);
+			zs.next_out  = band.deflated.data();
+			zs.avail_out = static_cast<uInt>(band.deflated.size());
+			int result   = ::deflate(&zs, last ? Z_FINISH : Z_SYNC_FLUSH);
+			band.ok      = (last ? result == Z_STREAM_END : result == Z_OK) && zs.avail_in == 0 && zs.avail_out > 0;
+			band.deflated.resize(zs.total_out);
+			::deflateEnd(&zs);
+			band.adler = ::adler32(::adler32(0L, Z_NULL, 0), &filtered[band.begin], static_cast<uInt>(band.size));
+		}
+
+		template <typename Fn>
+		void for_each_band(std::size_t bands, u32 threads, Fn&& fn) {
+			std::atomic<std::size_t> next = 0;
+			auto work = [&] {
+				for (std::size_t i = next++; i < bands; i = next++) {
+					fn(i);
+				}
+			};
+			std::vector<std::jthread> workers;
+			for (u32 i = 1; i < threads; ++i) {
+				workers.emplace_back(work);
+			}
+			work();
+		}
+
+	} // namespace
+
+	std::vector<unsigned char> encode_png(std::span<const unsigned char> pixels, u32 width, u32 height, u32 channels, const PngEncodeCfg& cfg) {
+		if (width == 0 || height == 0 || channels == 0 || channels > 4 || pixels.size() < std::size_t(width) * height * channels) {
+			FT_ERROR("Cannot encode a {}x{} png with {} channels from {} bytes", width, height, channels, pixels.size());
+			return {};
+		}
+		std::size_t stride    = std::size_t(width) * channels;
+		std::size_t band_rows = std::max<u32>(cfg.band_rows, 1);
+		std::size_t bands     = (height + band_rows - 1) / band_rows;
+		u32 threads           = cfg.threads != 0 ? cfg.threads : ThreadPool::on_worker() ? 1 : std::max(1u, std::thread::hardware_concurrency());
+		threads               = std::min<u32>(threads, static_cast<u32>(bands));
+		int level             = std::clamp(cfg.level, 0, 9);
+
+		// Filtering only reads the unfiltered previous row, so bands filter independently. Deflate
+		// waits for every band, it primes its window with the filtered bytes of the band before.
+		std::vector<unsigned char> filtered(std::size_t(height) * (stride + 1));
+		for_each_band(bands, threads, [&](std::size_t band) {
+			std::vector<unsigned char> trial(cfg.filter == EPngFilter::ADAPTIVE ? stride + 1 : 0);
+			std::size_t end = std::min<std::size_t>((band + 1) * band_rows, height);
+			for (std::size_t y = band * band_rows; y < end; ++y) {
+				const unsigned char* row  = &pixels[y * stride];
+				const unsigned char* prev = y > 0 ? &pixels[(y - 1) * stride] : nullptr;
+				unsigned char* out        = &filtered[y * (stride + 1)];
+				if (cfg.filter != EPngFilter::ADAPTIVE) {
+					filter_row(cfg.filter, row, prev, stride, channels, out);
+					continue;
+				}
+				u64 best = ~u64(0);
+				for (EPngFilter filter : { EPngFilter::NONE, EPngFilter::SUB, EPngFilter::UP, EPngFilter::AVERAGE, EPngFilter::PAETH }) {
+					filter_row(filter, row, prev, stride, channels, trial.data());
+					u64 cost = residual_cost(trial.data() + 1, stride);
+					if (cost < best) {
+						best = cost;
+						std::copy(trial.begin(), trial.end(), out);
+					}
+				}
+			}
+		});
+
+		std::vector<Band> parts(bands);
+		for (std::size_t i = 0; i < bands; ++i) {
+			parts[i].begin = i * band_rows * (stride + 1);
+			parts[i].size  = (std::min<std::size_t>((i + 1) * band_rows, height) - i * band_rows) * (stride + 1);
+		}
+		for_each_band(bands, threads, [&](std::size_t band) {
+			deflate_band(filtered, parts[band], band + 1 == bands, level, zlib_strategy(cfg.strategy));
+		});
+
+		std::vector<unsigned char> zlib;
+		u32 flevel = level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3;
+		u32 cmf    = 0x78; // Deflate with a 32KB window.
+		u32 flg    = flevel << 6;
+		flg       += 31 - (cmf * 256 + flg) % 31;
+		zlib.push_back(static_cast<unsigned char>(cmf));
+		zlib.push_back(static_cast<unsigned char>(flg));
+		uLong adler = 0;
+		for (std::size_t i = 0; i < bands; ++i) {
+			if (!parts[i].ok) {
+				FT_ERROR("Failed to deflate png band {} of {}", i, bands);
+				return {};
+			}
+			zlib.insert(zlib.end(), parts[i].deflated.begin(), parts[i].deflated.end());
+			adler = i == 0 ? parts[i].adler : ::adler32_combine(adler, parts[i].adler, static_cast<z_off_t>(parts[i].size));
+		}
+		put_u32(zlib, static_cast<u32>(adler));
+
+		constexpr unsigned char COLOR_TYPE[] = { 0, 0, 4, 2, 6 }; // Gray, gray alpha, rgb, rgba by channel count.
+		std::vector<unsigned char> ihdr;
+		put_u32(ihdr, width);
+		put_u32(ihdr, height);
+		ihdr.insert(ihdr.end(), { 8, COLOR_TYPE[channels], 0, 0, 0 }); // Depth, color type, deflate, adaptive filtering, no interlace.
+
+		std::vector<unsigned char> png(PNG_SIGNATURE.begin(), PNG_SIGNATURE.end());
+		png.reserve(zlib.size() + 128);
+		put_chunk(png, "IHDR", ihdr);
+		for (std::size_t offset = 0; offset < zlib.size(); offset += MAX_IDAT) {
+			put_chunk(png, "IDAT", std::span<const unsigned char>(zlib).subspan(offset, std::min(MAX_IDAT, zlib.size() - offset)));
+		}
+		put_chunk(png, "IEND", {});
+		return png;
+	}
+
+	bool write_png(const std::filesystem::path& file, std::span<const unsigned char> pixels, u32 width, u32 height, u32 channels, const PngEncodeCfg& cfg) {
+		std::vector<unsigned char> png = encode_png(pixels, width, height, channels, cfg);
+		if (png.empty()) {
+			return false;
+		}
+
+		return write_atomically(file, [&](std::ostream& out) { out.write(reinterpret_cast<const char*>(png.data()), png.size()); });
+	}
+
+} // namespace aby::ft
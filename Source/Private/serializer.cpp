@@ -10,34 +10,52 @@ namespace aby::ft {
 
 	void Serializer::reset() {
 		m_Data.clear();
+		m_Map.reset();
 		m_Offset = 0;
 	}
 	void Serializer::seek(i64 offset) {
 		m_Offset += offset;
 		FT_ASSERT(m_Offset >= 0, "Out of range");
-		FT_ASSERT(m_Offset < static_cast<int64_t>(m_Data.size()), "Out of range");
+		FT_ASSERT(m_Offset < static_cast<int64_t>(bytes().size()), "Out of range");
+	}
+	void Serializer::seek_to(std::size_t offset) {
+		FT_ASSERT(offset <= bytes().size(), "Out of range");
+		m_Offset = static_cast<i64>(offset);
 	}
 	void Serializer::set_mode(ESerializeMode mode) {
 		m_Opts.mode = mode;
 		if (mode == ESerializeMode::READ) {
 			reset();
 			read_file();
+		} else if (mode == ESerializeMode::MAP) {
+			reset();
+			map_file();
 		} else if (mode == ESerializeMode::WRITE) {
 			create_file();
 		}
 	}
-	void Serializer::save() {
+	void Serializer::align(std::size_t alignment) {
+		if (m_Opts.mode == ESerializeMode::WRITE) {
+			m_Data.resize((m_Data.size() + alignment - 1) / alignment * alignment, std::byte{ 0 });
+		} else {
+			m_Offset = (m_Offset + alignment - 1) / alignment * alignment;
+		}
+	}
+	std::shared_ptr<const MappedFile> Serializer::mapping() const {
+		return m_Map;
+	}
+	std::span<const std::byte> Serializer::bytes() const {
+		if (m_Opts.mode == ESerializeMode::MAP) {
+			return m_Map ? m_Map->bytes() : std::span<const std::byte>();
+		}
+		return m_Data;
+	}
+	bool Serializer::save() {
 		if (m_Data.empty()) {
 			FT_WARN("Attempting to save serialized data but Serializer::m_Data is empty");
-			return;
-		}
-		std::ofstream ofs(m_Opts.file, std::ios::binary);
-		if (ofs.is_open()) {
-			ofs.write(reinterpret_cast<const char*>(m_Data.data()), m_Data.size());
-			ofs.close();
-		} else {
-			FT_ERROR("Failed to open file for writing: {}", m_Opts.file.string());
+			return false;
 		}
+		return write_atomically(m_Opts.file, [this](std::ostream& out) { out.write(reinterpret_cast<const char*>(m_Data.data()), m_Data.size()); });
 	}
 
 	void Serializer::read_file() {
@@ -54,16 +72,17 @@ namespace aby::ft {
 		}
 	}
 
+	void Serializer::map_file() {
+		m_Map = m_Opts.mapping ? m_Opts.mapping : std::make_shared<MappedFile>(m_Opts.file);
+		if (!m_Map->is_open()) {
+			FT_ERROR("Failed to map file for reading: {}", m_Opts.file.string());
+		}
+	}
+
 	void Serializer::create_file() {
 		if (!std::filesystem::exists(m_Opts.file.parent_path())) {
 			std::filesystem::create_directories(m_Opts.file.parent_path());
 		}
-		std::ofstream ofs(m_Opts.file, std::ios::binary | std::ios::trunc);
-		if (ofs.is_open()) {
-			ofs.close();
-		} else {
-			FT_ERROR("Failed to open file for writing: {}", m_Opts.file.string());
-		}
 	}
 
 } // namespace aby::ft
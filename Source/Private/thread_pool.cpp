@@ -0,0 +1,51 @@
+#include "FT/thread_pool.h"
+
+#include <algorithm>
+
+namespace aby::ft {
+
+	ThreadPool::ThreadPool(u32 threads) {
+		if (threads == 0) {
+			threads = std::max(1u, std::thread::hardware_concurrency());
+		}
+		m_Workers.reserve(threads);
+		for (u32 i = 0; i < threads; ++i) {
+			m_Workers.emplace_back([this] { run(); });
+		}
+	}
+
+	ThreadPool::~ThreadPool() {
+		{
+			std::lock_guard lock(m_Mutex);
+			m_Stop = true;
+		}
+		m_Signal.notify_all();
+		for (auto& worker : m_Workers) {
+			worker.join();
+		}
+	}
+
+	u32 ThreadPool::size() const {
+		return static_cast<u32>(m_Workers.size());
+	}
+
+	bool ThreadPool::on_worker() {
+		return s_OnWorker;
+	}
+
+	void ThreadPool::run() {
+		s_OnWorker = true;
+		for (;;) {
+			std::move_only_function<void()> task;
+			{
+				std::unique_lock lock(m_Mutex);
+				m_Signal.wait(lock, [this] { return m_Stop || !m_Tasks.empty(); });
+				if (m_Tasks.empty()) return; // Stopped and drained.
+				task = std::move(m_Tasks.front());
+				m_Tasks.pop_front();
+			}
+			task();
+		}
+	}
+
+} // namespace aby::ft
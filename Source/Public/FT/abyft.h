@@ -1,10 +1,23 @@
 #pragma once
+#include <condition_variable>
 #include <filesystem>
+#include <functional>
+#include <future>
+#include <list>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <stop_token>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include "FT/common.h"
+#include "FT/hash.h"
+#include "FT/packer.h"
+#include "FT/png_encoder.h"
 
 namespace aby::ft {
 
@@ -31,17 +44,78 @@ namespace aby::ft {
             { 0.f, 0.f },
             { 0.f, 0.f }
 		};
-		u64 reserved = 0;
+		u32 page           = 0; // Index into FontData::pages.
+		char32_t codepoint = 0;
 	};
 	static_assert(sizeof(Glyph) == 64);
 	using Glyphs = std::unordered_map<char32_t, Glyph>;
 
-	struct FontData {
-		Glyphs glyphs             = {};
-		float text_height         = 0.f;
-		bool is_mono              = false;
-		std::string name          = "";
-		std::filesystem::path png = "";
+	inline constexpr char32_t INVALID_CODEPOINT = ~char32_t(0);
+	inline constexpr char32_t MAX_CODEPOINT     = 0x10FFFF;
+
+	/**
+	 * @brief Flat glyph table indexed by codepoint - first codepoint.
+	 *        Codepoints without a glyph hold a zeroed glyph with INVALID_CODEPOINT.
+	 */
+	class DenseGlyphs {
+	public:
+		DenseGlyphs() = default;
+		explicit DenseGlyphs(std::span<const Glyph> sorted_records);
+
+		const Glyph* find(char32_t c) const {
+			std::size_t idx = static_cast<char32_t>(c - m_Start); // Wraps below start, so one compare covers both ends.
+			if (idx >= m_Glyphs.size() || m_Glyphs[idx].codepoint != c) return nullptr;
+			return &m_Glyphs[idx];
+		}
+
+		/**
+		 * @brief Never fails, missing glyphs return the sentinel (codepoint == INVALID_CODEPOINT).
+		 */
+		const Glyph& operator[](char32_t c) const {
+			std::size_t idx = static_cast<char32_t>(c - m_Start);
+			return idx < m_Glyphs.size() ? m_Glyphs[idx] : s_Missing;
+		}
+
+		char32_t start() const { return m_Start; }
+		std::size_t size() const { return m_Glyphs.size(); }
+		bool empty() const { return m_Glyphs.empty(); }
+	private:
+		char32_t m_Start            = 0;
+		std::vector<Glyph> m_Glyphs = {};
+		static inline const Glyph s_Missing = Glyph{ .codepoint = INVALID_CODEPOINT };
+	};
+
+	/**
+	 * @brief Minimal perfect hash (hash and displace) over the codepoints of a sorted record array.
+	 *        Every key lands in its own slot after one seed lookup, the slot holds the record index.
+	 */
+	class PerfectGlyphHash {
+	public:
+		PerfectGlyphHash() = default;
+		explicit PerfectGlyphHash(std::span<const Glyph> sorted_records);
+		PerfectGlyphHash(std::span<const Glyph> sorted_records, std::span<const u32> seeds, std::span<const u32> slots);
+
+		/**
+		 * @brief Whether seeds and slots read from a file can serve record_count records, find trusts every slot.
+		 */
+		static bool valid(std::size_t record_count, std::span<const u32> seeds, std::span<const u32> slots);
+
+		const Glyph* find(char32_t c) const {
+			if (m_Slots.empty()) return nullptr;
+			u32 seed       = m_Seeds[reduce(static_cast<u32>(mix64(c)), static_cast<u32>(m_Seeds.size()))];
+			u32 slot       = reduce(static_cast<u32>(mix64(c ^ (u64(seed) << 32))), static_cast<u32>(m_Slots.size()));
+			const Glyph* g = &m_Records[m_Slots[slot]];
+			return g->codepoint == c ? g : nullptr;
+		}
+
+		std::span<const u32> seeds() const { return m_Seeds; }
+		std::span<const u32> slots() const { return m_Slots; }
+		bool empty() const { return m_Slots.empty(); }
+	private:
+		std::span<const Glyph> m_Records                = {};
+		std::span<const u32> m_Seeds                    = {};
+		std::span<const u32> m_Slots                    = {};
+		std::shared_ptr<const std::vector<u32>> m_Owned = nullptr; // Seeds followed by slots when built in memory.
 	};
 
 	struct CharRange {
@@ -49,12 +123,148 @@ namespace aby::ft {
 		char32_t end   = 128;
 	};
 
+	/**
+	 * @brief Bitset of every codepoint the font's cmap maps to a glyph, including ones that were not loaded.
+	 *        Use it to decide between rasterizing on demand and falling back to another font.
+	 */
+	class Coverage {
+	public:
+		Coverage() = default;
+		explicit Coverage(std::span<const CharRange> sorted_ranges);
+
+		/**
+		 * @brief Whether ranges read from a file are ascending, non-empty, disjoint and within unicode.
+		 */
+		static bool valid(std::span<const CharRange> ranges);
+
+		bool contains(char32_t c) const {
+			std::size_t word = c >> 6;
+			return word < m_Bits.size() && (m_Bits[word] >> (c & 63)) & 1;
+		}
+
+		/**
+		 * @brief Maximal runs of covered codepoints, this is how coverage is stored in the cache.
+		 */
+		std::vector<CharRange> ranges() const;
+		std::size_t count() const { return m_Count; }
+		bool empty() const { return m_Count == 0; }
+	private:
+		std::vector<u64> m_Bits = {};
+		std::size_t m_Count     = 0;
+	};
+
+	enum class EGlyphLookup : u32 {
+		SORTED       = 0, // Binary search over FontData::records.
+		DENSE        = 1, // FontData::dense, best for contiguous ranges such as ascii.
+		PERFECT_HASH = 2, // FontData::hash, best for sparse sets, persisted in the cache so it is never rebuilt on load.
+	};
+
+	enum class EAtlasFormat : u32 {
+		RGBA8 = 0, // Coverage expanded to rgb with opaque alpha.
+		R8    = 1, // Coverage only, one byte per texel.
+	};
+
+	enum class ERenderMode : u32 {
+		COVERAGE = 0, // Anti-aliased coverage, one atlas per point size.
+		SDF      = 1, // Signed distance field, 128 is the outline. One atlas serves every size, scale metrics by pt / FontData::pt.
+	};
+
+	enum class ECacheLayout : u32 {
+		FILES  = 0, // A .bin glyph table next to one .png/.atlas per page.
+		BUNDLE = 1, // One .abft file holding the glyph table and the raw pages, warm loads are a single map.
+	};
+
+	constexpr u32 texel_size(EAtlasFormat format) {
+		return format == EAtlasFormat::R8 ? 1 : 4;
+	}
+
+	struct AtlasPage {
+		std::filesystem::path png             = ""; // Empty unless FontCfg::write_png.
+		std::filesystem::path raw             = ""; // Empty unless FontCfg::write_raw, see MappedAtlas.
+		u32 width                             = 0;
+		u32 height                            = 0;
+		std::span<const unsigned char> pixels = {}; // Texels of the page, kept alive by FontData::storage. Empty when loaded from an ECacheLayout::FILES cache, map raw instead.
+	};
+
+	struct FontData {
+		Glyphs glyphs                = {};
+		float text_height            = 0.f;
+		bool is_mono                 = false;
+		std::string name             = "";
+		std::filesystem::path png    = ""; // Same as pages[0].png.
+		std::vector<AtlasPage> pages = {};
+		EAtlasFormat format          = EAtlasFormat::RGBA8;
+		ERenderMode render_mode      = ERenderMode::COVERAGE;
+		u32 pt                       = 0; // Size the atlas was baked at.
+		u32 sdf_spread               = 0; // Distance in texels at which the field saturates, 0 unless SDF.
+		u64 key                      = 0; // Cache key, hash of the font file bytes and every parameter that affects the bake.
+
+		// Every glyph sorted by codepoint, points straight into the mapped cache file when loaded from cache.
+		std::span<const Glyph> records      = {};
+		std::shared_ptr<const void> storage = nullptr; // Keeps records alive.
+		EGlyphLookup lookup                 = EGlyphLookup::SORTED;
+		DenseGlyphs dense                   = {}; // Only filled for EGlyphLookup::DENSE.
+		PerfectGlyphHash hash               = {}; // Only filled for EGlyphLookup::PERFECT_HASH.
+		Coverage coverage                   = {};
+
+		/**
+		 * @brief Looks up a glyph through the table selected by FontCfg::lookup,
+		 *        works even when glyphs was not filled (FontCfg::glyph_map).
+		 */
+		const Glyph* find(char32_t c) const;
+	};
+
+	/**
+	 * @brief Glyphs of one raster chunk that landed on the same page, handed out while a streaming
+	 *        bake (FontCfg::on_batch) runs so they can be uploaded and drawn before the rest is done.
+	 */
+	struct GlyphBatch {
+		std::span<const Glyph> glyphs         = {}; // Final records in codepoint order, only valid during the callback.
+		u32 page                              = 0;
+		u32 page_width                        = 0;
+		u32 page_height                       = 0;
+		Rect rect                             = {}; // Part of the page covering the glyphs, empty if none has pixels.
+		std::span<const unsigned char> pixels = {}; // Texels of rect in FontCfg::format, rect.w texels per row.
+		EAtlasFormat format                   = EAtlasFormat::RGBA8;
+	};
+
+	using GlyphBatchCallback = std::function<void(const GlyphBatch&)>;
+
 	struct FontCfg {
-		u32 pt                     = 14;
-		vec2 dpi                   = { 96.f, 96.f };
-		CharRange range            = { 32, 128 };
-		std::filesystem::path path = "";
-		bool verbose               = false;
+		u32 pt                        = 14;
+		vec2 dpi                      = { 96.f, 96.f };
+		CharRange range               = { 32, 128 };
+		std::vector<CharRange> ranges = {}; // Loaded together with range, set range to { 0, 0 } to only load these.
+		std::filesystem::path charset = ""; // UTF-8 text file (e.g. every UI string), each codepoint in it is loaded too.
+		std::filesystem::path path    = "";
+		u32 max_page_size             = 4096;  // Upper bound for either page dimension, glyphs that do not fit spill onto more pages. At most 65536.
+		u32 padding                   = 1;     // Empty texels between packed glyphs.
+		bool uniform_pages            = false; // Give every page the same size so they can be uploaded as an array texture.
+		EAtlasFormat format           = EAtlasFormat::RGBA8;
+		ERenderMode render_mode       = ERenderMode::COVERAGE;
+		u32 sdf_pt                    = 48; // Size SDF atlases are baked at instead of pt, so every pt shares one atlas.
+		u32 sdf_spread                = 8;  // Texels of distance around each glyph in SDF mode, 2 to 32.
+		bool write_png                = true; // Encoded atlas, for debugging/exporting or engines that decode png.
+		PngEncodeCfg png              = {};   // Compression level, filter and threads of the png encoder.
+		bool write_raw                = true; // Uncompressed atlas that can be memory mapped and uploaded without decoding.
+		ECacheLayout cache_layout     = ECacheLayout::FILES; // BUNDLE ignores write_png and write_raw, pages are in AtlasPage::pixels.
+		bool glyph_map                = true; // Fill FontData::glyphs, disable to only reference the cached records in place.
+		EGlyphLookup lookup           = EGlyphLookup::SORTED;
+		bool map_font                 = true; // Open the font from a memory mapping shared by every face of the file, instead of FreeType's own file reads.
+		bool write_behind             = false; // Return a baked font before its cache files are written, a background writer saves them. Upload AtlasPage::pixels meanwhile, see Library::flush.
+		u32 threads                   = 1; // Rasterization threads, 0 uses every hardware thread (one on a batch or async pool worker). Output does not depend on it.
+		bool verbose                  = false;
+		// Streaming bake: glyphs are packed in codepoint order onto max_page_size pages and delivered per chunk
+		// on the baking thread. Cache hits return the whole font without calling it.
+		// Every page, the last one included, stays max_page_size square because streamed texcoords are relative to it.
+		// At the default 4096 even an ascii bake costs 16MB (R8) or 64MB (RGBA8) and writes full size page files,
+		// set max_page_size to the texture you upload into, e.g. 512 or 1024.
+		GlyphBatchCallback on_batch = nullptr;
+
+		/**
+		 * @brief Sorted, unique codepoints selected by range, ranges and charset.
+		 */
+		std::vector<char32_t> codepoints() const;
 	};
 
 	struct Version {
@@ -104,34 +314,142 @@ namespace std {
 
 struct FT_FaceRec_;
 struct FT_LibraryRec_;
+struct FT_SizeRec_;
 
 namespace aby::ft {
 
+	class ThreadPool;
+	class CacheManifest;
+	struct CacheManifestEntry;
+	class MappedFile;
+	class DynamicAtlas;
+	struct DynamicAtlasCfg;
+
 	/**
      * @brief Font Library Singleton class
+     *
+     *        Every public function may be called from any number of threads at once. Each request
+     *        opens its own faces and keeps its own log, the shared FT_Library is only locked briefly
+     *        around face creation/destruction. Concurrent requests for the same cache files are safe,
+     *        each writes to a private temp file and the last rename wins with identical contents.
+     *        On Windows a file can only be replaced while every open handle to it shares delete access.
+     *        The library's mappings do. Handles opened elsewhere (another program, or FreeType's own
+     *        reads with FontCfg::map_font off) block it: a cache rename then fails and is logged, and
+     *        a font file cannot be swapped until those handles close.
+     *        FontData is immutable once returned and may be shared between threads, DynamicAtlas may not.
     */
 	class Library {
 	public:
 		static Library& get();
 
 		FontData create_font_data(const std::filesystem::path& cache_dir, const FontCfg& cfg);
+
+		/**
+		 * @brief Loads every config on the library's worker pool. Configs of the same font file
+		 *        share a face. Results are in the same order as cfgs. Called from a pool worker,
+		 *        e.g. inside an on_batch callback, the configs are loaded on the calling thread.
+		 */
+		std::vector<FontData> create_font_data_batch(const std::filesystem::path& cache_dir, std::span<const FontCfg> cfgs);
+
+		/**
+		 * @brief Loads cfg on the library's worker pool and returns immediately. Requesting a stop on
+		 *        cancel before or while the font bakes resolves the future with an empty FontData,
+		 *        a cancelled bake writes nothing to the cache.
+		 */
+		std::future<FontData> create_font_data_async(const std::filesystem::path& cache_dir, const FontCfg& cfg, std::stop_token cancel = {});
+
+		/**
+		 * @brief Atlas that rasterizes glyphs on demand, for text that is not known up front. See dynamic_atlas.h.
+		 */
+		std::unique_ptr<DynamicAtlas> create_dynamic_atlas(const DynamicAtlasCfg& cfg);
+
+		/**
+		 * @brief Blocks until every cache write queued by FontCfg::write_behind is on disk.
+		 *        Loads of an entry that is still being written wait for it on their own, the destructor flushes too.
+		 */
+		void flush();
 		
 		static constexpr Version version() { return s_Version; }
 	private:
-		::FT_FaceRec_* create_face(const FontCfg& cfg);
-		void destroy_face(::FT_FaceRec_* face, const FontCfg& cfg);
-		FontData load_glyph_range(const std::filesystem::path& cache_dir, const FontCfg& cfg);
-		FontData load_glyph_range_ttf(FT_FaceRec_* face, const std::filesystem::path& png_file, const FontCfg& cfg);
-		FontData load_glyph_range_bin(const std::filesystem::path& cache, const FontCfg& cfg);
-		void cache_glyphs(const std::filesystem::path& cache_dir, const std::string& name, const FontData& data, const FontCfg& cfg);
-		std::filesystem::path cache_path(const std::filesystem::path& cache_dir, const std::string& name, const std::filesystem::path& ext, const FontCfg& cfg);
+		friend class DynamicAtlas;
+
+		/**
+		 * @brief State of one request, never shared between threads.
+		 */
+		struct LoadContext {
+			std::string log        = ""; // Verbose output, printed in one piece when the request finishes.
+			std::stop_token cancel = {}; // Checked between raster chunks, see create_font_data_async.
+			std::vector<std::move_only_function<bool()>> page_writes = {}; // Page files held back for the cache writer, see FontCfg::write_behind.
+			bool pages_written     = true; // False once a page file failed to write, the glyph file is then not cached.
+		};
+
+		/**
+		 * @brief Exclusive use of a face of cfg.path sized for cfg, reusing an idle cached face when there is one.
+		 *        Give it back with release_face.
+		 */
+		::FT_FaceRec_* acquire_face(const FontCfg& cfg);
+		void set_face_size(::FT_FaceRec_* face, const FontCfg& cfg);
+		void release_face(::FT_FaceRec_* face);
+		void destroy_face(::FT_FaceRec_* face); // Requires m_FaceMutex, face must not be idle.
+		void evict_faces(const std::string& path);
+		std::shared_ptr<const MappedFile> map_font_file(const std::string& path); // Requires m_FaceMutex.
+		FontData load_glyph_range(LoadContext& ctx, const std::filesystem::path& cache_dir, const FontCfg& cfg, ::FT_FaceRec_** shared_face = nullptr);
+		std::optional<FontData> load_glyph_range_ttf(LoadContext& ctx, FT_FaceRec_* face, std::span<const char32_t> requested, const std::filesystem::path& png_file, const std::filesystem::path& raw_file, const FontCfg& cfg); // std::nullopt if the glyphs do not fit, never cached.
+		std::optional<FontData> load_glyph_range_bin(const std::filesystem::path& cache, std::shared_ptr<MappedFile> mapping, const std::filesystem::path& png_file, const std::filesystem::path& raw_file, const FontCfg& cfg, u64 key);
+		std::optional<CacheManifestEntry> cache_glyphs(const std::filesystem::path& bin_cache_path, const FontData& data, const FontCfg& cfg); // Entry of the written file, std::nullopt on failure.
+		CacheManifest& manifest(const std::filesystem::path& dir); // Requires m_ManifestMutex.
+		void queue_cache_write(LoadContext& ctx, const std::filesystem::path& glyph_file, const FontData& data, const FontCfg& cfg);
+		void wait_cache_write(const std::filesystem::path& glyph_file);
+		void build_lookup(FontData& data, const FontCfg& cfg);
+		ThreadPool& pool();
+		ThreadPool& writer();
+		std::shared_lock<std::shared_mutex> lock_sdf_spread(u32 spread);
+		void flush_log(LoadContext& ctx);
+		std::optional<u64> font_hash(const std::filesystem::path& font); // std::nullopt if the font cannot be read.
+		std::optional<u64> cache_key(const FontCfg& cfg, std::span<const char32_t> codepoints);
+		std::filesystem::path cache_path(const std::filesystem::path& cache_dir, const std::string& name, const std::filesystem::path& ext, u64 key);
 
 		Library();
 		~Library();
 	private:
 		::FT_LibraryRec_* m_Library               = nullptr;
-		std::ostringstream m_VerboseStream		  = {};		
+		struct CachedFace {
+			std::string path                              = "";
+			std::unordered_map<u64, ::FT_SizeRec_*> sizes = {}; // One FT_Size per pt/dpi, switching between them skips rescaling.
+			std::shared_ptr<const MappedFile> file        = nullptr; // Backs the face when FontCfg::map_font, must outlive it.
+			bool stale                                    = false;   // The file changed while the face was in use, destroyed on release.
+		};
+		std::mutex m_FaceMutex; // Guards the FT_Library, m_Faces and m_IdleFaces, never held while a face is in use.
+		std::unordered_map<::FT_FaceRec_*, CachedFace> m_Faces;
+		std::list<::FT_FaceRec_*> m_IdleFaces; // Most recently released first.
+		std::unordered_map<std::string, std::weak_ptr<const MappedFile>> m_FontFiles; // One mapping per font file.
+		struct FontHash {
+			std::uintmax_t size                   = 0;
+			std::filesystem::file_time_type mtime = {};
+			u64 hash                              = 0;
+		};
+		std::mutex m_HashMutex;
+		std::unordered_map<std::string, FontHash> m_FontHashes; // Revalidated by size and mtime, so each font is read once.
+		std::mutex m_PrintMutex; // Keeps logs of concurrent requests from interleaving.
+		std::shared_mutex m_SdfMutex;
+		u32 m_SdfSpread                           = 0; // The FreeType sdf spread is a module property shared by every face.
+		std::mutex m_ManifestMutex;
+		std::unordered_map<std::string, std::unique_ptr<CacheManifest>> m_Manifests; // One per cache directory, read on first use.
+		std::once_flag m_PoolOnce;
+		std::unique_ptr<ThreadPool> m_Pool;
+		std::mutex m_WriteMutex;
+		std::condition_variable m_WriteDone;
+		std::unordered_map<std::string, u32> m_PendingWrites; // Queued cache writes per glyph file, guarded by m_WriteMutex.
+		std::once_flag m_WriterOnce;
+		std::unique_ptr<ThreadPool> m_Writer; // One thread, so cache writes land in the order they were queued.
 		static inline constexpr Version s_Version = Version(ABY_FT_VER_MAJOR, ABY_FT_VER_MINOR, ABY_FT_VER_PATCH);
+		static inline constexpr u32 s_CacheVersion    = 7;  // Bump whenever the .bin layout changes, stale files are rebuilt.
+		static inline constexpr u32 s_RecordAlignment = 64; // Glyph records start on a cache line in the .bin file.
+		static inline constexpr u32 s_MaxDenseSpan    = 1024; // Dense tables may always cover this many codepoints.
+		static inline constexpr u32 s_RasterChunk     = 32;   // Codepoints a rasterization thread claims at once.
+		static inline constexpr u32 s_MaxIdleFaces    = 16;   // Parsed faces kept around after their last use.
+		static inline constexpr u32 s_MaxFaceSizes    = 16;   // FT_Size objects kept per face.
+		static inline constexpr u32 s_MaxPageSize     = 1u << 16; // Largest FontCfg::max_page_size, Glyph::offset must hold y * width + x.
 	};
 
 } // namespace aby::ft
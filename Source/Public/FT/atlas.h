@@ -0,0 +1,45 @@
+#pragma once
+#include <filesystem>
+#include <span>
+
+#include "FT/abyft.h"
+#include "FT/mapped_file.h"
+
+namespace aby::ft {
+
+	inline constexpr u32 RAW_ATLAS_MAGIC   = 0x41594241; // "ABYA"
+	inline constexpr u32 RAW_ATLAS_VERSION = 1;
+
+	/**
+	 * @brief Header of a raw atlas page, pixels start at data_offset and
+	 *        are tightly packed rows of row_pitch bytes.
+	 */
+	struct RawAtlasHeader {
+		u32 magic           = RAW_ATLAS_MAGIC;
+		u32 version         = RAW_ATLAS_VERSION;
+		u32 width           = 0;
+		u32 height          = 0;
+		EAtlasFormat format = EAtlasFormat::RGBA8;
+		u32 row_pitch       = 0;
+		u64 data_offset     = 64;
+	};
+	static_assert(sizeof(RawAtlasHeader) == 32);
+
+	bool write_raw_atlas(const std::filesystem::path& file, u32 width, u32 height, EAtlasFormat format, std::span<const unsigned char> pixels);
+
+	/**
+	 * @brief Memory mapped raw atlas page, pixels() can be handed directly to a texture upload.
+	 */
+	class MappedAtlas {
+	public:
+		explicit MappedAtlas(const std::filesystem::path& file);
+
+		bool is_open() const;
+		const RawAtlasHeader& header() const;
+		std::span<const std::byte> pixels() const;
+	private:
+		MappedFile m_File;
+		const RawAtlasHeader* m_Header = nullptr;
+	};
+
+} // namespace aby::ft
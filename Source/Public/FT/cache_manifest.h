@@ -0,0 +1,66 @@
+#pragma once
+#include <filesystem>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "FT/abyft.h"
+
+namespace aby::ft {
+
+	inline constexpr u32 CACHE_MANIFEST_MAGIC   = 0x4D464241; // "ABFM"
+	inline constexpr u32 CACHE_MANIFEST_VERSION = 2;
+
+	struct CacheManifestPage {
+		u32 width  = 0;
+		u32 height = 0;
+		u64 offset = 0; // ECacheLayout::BUNDLE only, texels of the page from the start of the .abft file.
+
+		bool operator==(const CacheManifestPage&) const = default;
+	};
+	static_assert(sizeof(CacheManifestPage) == 16);
+
+	/**
+	 * @brief One complete cache entry. Only recorded once every file of the entry is in place,
+	 *        so a listed entry whose glyph file still has the recorded size is loaded without probing its pages.
+	 */
+	struct CacheManifestEntry {
+		u64 key             = 0; // Library::cache_key, also part of the file name.
+		u64 size            = 0; // Bytes of the .bin or .abft file.
+		u64 glyph_count     = 0;
+		ECacheLayout layout = ECacheLayout::FILES;
+		bool png            = false; // Page pngs were written, ECacheLayout::FILES only.
+		bool raw            = false; // Raw .atlas pages were written, ECacheLayout::FILES only.
+		std::vector<CacheManifestPage> pages = {};
+
+		bool covers(const FontCfg& cfg) const; // Every page file cfg asks for was written.
+	};
+
+	/**
+	 * @brief Index of a cache directory, stored as manifest.bin next to the entries.
+	 *        Read once, then answered from memory. Not thread safe, Library serializes access.
+	 */
+	class CacheManifest {
+	public:
+		explicit CacheManifest(const std::filesystem::path& dir);
+
+		std::optional<CacheManifestEntry> find(u64 key) const;
+
+		/**
+		 * @brief Records entry and rewrites the manifest. Entries other processes added since it
+		 *        was read are merged in first, the file is replaced atomically.
+		 */
+		void insert(const CacheManifestEntry& entry);
+		void erase(u64 key);
+
+		std::size_t size() const;
+		const std::filesystem::path& file() const;
+	private:
+		static std::unordered_map<u64, CacheManifestEntry> read(const std::filesystem::path& file);
+		void write();
+	private:
+		std::filesystem::path m_File;
+		std::unordered_map<u64, CacheManifestEntry> m_Entries;
+	};
+
+} // namespace aby::ft
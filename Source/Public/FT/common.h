@@ -55,7 +55,7 @@ extern "C" __declspec(dllimport) void __stdcall DebugBreak();
 #	define ABY_FT_VER_MAJOR 1
 #endif
 #ifndef ABY_FT_VER_MINOR
-#	define ABY_FT_VER_MINOR 0
+#	define ABY_FT_VER_MINOR 1
 #endif
 #ifndef ABY_FT_VER_PATCH
 #	define ABY_FT_VER_PATCH 0
@@ -65,6 +65,7 @@ namespace aby::ft {
 
 	using u32 = std::uint32_t;
 	using u64 = std::uint64_t;
+	using i32 = std::int32_t;
 	using i64 = std::int64_t;
 
 } // namespace aby::ft
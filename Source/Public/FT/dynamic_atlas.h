@@ -0,0 +1,96 @@
+#pragma once
+#include <filesystem>
+#include <list>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "FT/abyft.h"
+#include "FT/packer.h"
+
+namespace aby::ft {
+
+	struct DynamicAtlasCfg {
+		u32 pt                     = 14;
+		vec2 dpi                   = { 96.f, 96.f };
+		std::filesystem::path path = "";
+		u32 width                  = 1024; // Fixed budget, the atlas never grows.
+		u32 height                 = 1024;
+		u32 padding                = 1;
+		EAtlasFormat format        = EAtlasFormat::R8;
+	};
+
+	/**
+	 * @brief Single page atlas that rasterizes glyphs on first use. Glyphs are packed by their bitmap
+	 *        size onto shelves of a few fixed heights, when nothing fits the least recently used glyphs
+	 *        are evicted. Glyphs used during the current frame are never evicted, so pointers returned
+	 *        by get() stay valid until next_frame(). Not thread safe, use one atlas per render thread.
+	 */
+	class DynamicAtlas {
+	public:
+		~DynamicAtlas();
+
+		DynamicAtlas(const DynamicAtlas&)            = delete;
+		DynamicAtlas& operator=(const DynamicAtlas&) = delete;
+
+		/**
+		 * @brief Returns nullptr if the font has no glyph for c, or if it does not fit beside the glyphs used this frame.
+		 */
+		const Glyph* get(char32_t c);
+		void next_frame();
+
+		/**
+		 * @brief Regions changed since the last call, only these need to be uploaded again.
+		 */
+		std::vector<Rect> take_dirty();
+
+		std::span<const unsigned char> pixels() const;
+		u32 width() const;
+		u32 height() const;
+		EAtlasFormat format() const;
+		float text_height() const;
+		std::size_t size() const; // Glyphs currently resident.
+	private:
+		friend class Library;
+		DynamicAtlas(Library& lib, ::FT_FaceRec_* face, const DynamicAtlasCfg& cfg);
+
+		// A row of slots as tall as the glyphs it holds, rounded up to s_SlotStep. Freed slots are
+		// reused by glyphs of the same height class, so eviction never fragments the atlas.
+		struct Shelf {
+			u32 y                  = 0;
+			u32 height             = 0; // Padding included.
+			u32 cursor             = 0; // Start of the never used tail.
+			u32 live               = 0; // Resident glyphs, an empty shelf is reset.
+			std::vector<Rect> free = {}; // Slots of evicted glyphs, padding included.
+		};
+		struct Entry {
+			Glyph glyph;
+			Rect slot = {};
+			u32 shelf = 0;
+			u64 frame = 0;
+		};
+		using Lru = std::list<Entry>; // Most recently used first.
+
+		bool acquire_slot(u32 width, u32 height, Rect& slot, u32& shelf);
+		bool place(u32 width, u32 height, Rect& slot, u32& shelf);
+		void evict(Lru::iterator it);
+		void clear(const Rect& rect);
+	private:
+		Library& m_Library;
+		::FT_FaceRec_* m_Face = nullptr;
+		DynamicAtlasCfg m_Cfg;
+		float m_TextHeight = 0.f;
+		u32 m_ShelfTop     = 0; // Start of the rows no shelf uses yet.
+		u64 m_Frame        = 1;
+		std::vector<unsigned char> m_Pixels;
+		std::vector<Shelf> m_Shelves; // Sorted by y.
+		Lru m_Lru;
+		std::unordered_map<char32_t, Lru::iterator> m_Resident;
+		std::unordered_set<char32_t> m_Missing;
+		std::vector<Rect> m_Dirty;
+
+		static inline constexpr u32 s_SlotStep = 4; // Slot sizes are rounded up to it, so freed slots fit similar glyphs.
+	};
+
+} // namespace aby::ft
@@ -0,0 +1,66 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <span>
+
+#include "FT/common.h"
+
+namespace aby::ft {
+
+	/**
+	 * @brief splitmix64 finalizer, cheap and well distributed for small integer keys.
+	 */
+	constexpr u64 mix64(u64 x) {
+		x ^= x >> 30;
+		x *= 0xbf58476d1ce4e5b9ull;
+		x ^= x >> 27;
+		x *= 0x94d049bb133111ebull;
+		x ^= x >> 31;
+		return x;
+	}
+
+	/**
+	 * @brief Maps a 32 bit hash onto [0, n) without a division.
+	 */
+	constexpr u32 reduce(u32 hash, u32 n) {
+		return static_cast<u32>((u64(hash) * n) >> 32);
+	}
+
+	/**
+	 * @brief Non cryptographic hash of a byte buffer. Four independent lanes of 8 bytes keep it
+	 *        close to memory bandwidth, so hashing a whole font file costs about as much as reading it.
+	 */
+	inline u64 hash_bytes(std::span<const std::byte> bytes, u64 seed = 0) {
+		constexpr u64 P1 = 0x9e3779b185ebca87ull;
+		constexpr u64 P2 = 0xc2b2ae3d27d4eb4full;
+		auto load = [](const std::byte* p) {
+			u64 word;
+			std::memcpy(&word, p, sizeof(word));
+			return word;
+		};
+		auto round = [](u64 acc, u64 word) {
+			return std::rotl(acc + word * P2, 31) * P1;
+		};
+
+		const std::byte* p = bytes.data();
+		std::size_t n      = bytes.size();
+		u64 lanes[4]       = { seed + P1 + P2, seed + P2, seed, seed - P1 };
+		for (; n >= 32; p += 32, n -= 32) {
+			lanes[0] = round(lanes[0], load(p));
+			lanes[1] = round(lanes[1], load(p + 8));
+			lanes[2] = round(lanes[2], load(p + 16));
+			lanes[3] = round(lanes[3], load(p + 24));
+		}
+		u64 hash = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) + std::rotl(lanes[3], 18);
+		hash ^= bytes.size();
+		for (; n >= 8; p += 8, n -= 8) {
+			hash = mix64(hash ^ load(p));
+		}
+		for (; n > 0; ++p, --n) {
+			hash = mix64(hash ^ std::to_integer<u64>(*p));
+		}
+		return mix64(hash);
+	}
+
+} // namespace aby::ft
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+
+#include "FT/common.h"
+
+namespace aby::ft {
+
+	enum class EKernelIsa : u32 {
+		SCALAR = 0,
+		SSE2   = 1,
+		AVX2   = 2,
+		NEON   = 3,
+	};
+
+	/**
+	 * @brief Widest instruction set the kernels can use on this machine, detected once at runtime.
+	 */
+	EKernelIsa kernel_isa();
+	bool kernel_supported(EKernelIsa isa);
+	const char* kernel_isa_name(EKernelIsa isa);
+
+	/**
+	 * @brief Copies rows bytes wide between buffers of different pitch, e.g. a glyph bitmap into an atlas page.
+	 *        src and dst point at the top row, row i starts pitch * i bytes from it. Pitches may be negative.
+	 */
+	void blit_rows(const unsigned char* src, std::ptrdiff_t src_pitch, unsigned char* dst, std::ptrdiff_t dst_pitch, std::size_t row_bytes, u32 rows);
+
+	/**
+	 * @brief Top row of a FreeType bitmap. Bitmaps with a negative pitch flow upwards, their buffer starts at the bottom row.
+	 */
+	const unsigned char* top_row(const unsigned char* buffer, std::ptrdiff_t pitch, u32 rows);
+
+	/**
+	 * @brief Expands count coverage bytes to rgba8 texels, coverage in rgb with opaque alpha.
+	 *        dst must hold count * 4 bytes.
+	 */
+	void expand_r8_rgba8(const unsigned char* src, unsigned char* dst, std::size_t count);
+
+	/**
+	 * @brief Same with an explicit instruction set, for benchmarks and tests. isa must be supported.
+	 */
+	void expand_r8_rgba8(const unsigned char* src, unsigned char* dst, std::size_t count, EKernelIsa isa);
+
+} // namespace aby::ft
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <iosfwd>
+#include <span>
+
+#include "FT/common.h"
+
+namespace aby::ft {
+
+	/**
+	 * @brief Read-only memory mapping of a whole file.
+	 */
+	class MappedFile {
+	public:
+		MappedFile() = default;
+		explicit MappedFile(const std::filesystem::path& file);
+		~MappedFile();
+
+		MappedFile(const MappedFile&)            = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+
+		bool is_open() const;
+		const std::byte* data() const;
+		std::size_t size() const;
+		std::span<const std::byte> bytes() const;
+	private:
+		void close();
+	private:
+		const std::byte* m_Data = nullptr;
+		std::size_t m_Size      = 0;
+#ifdef _WIN32
+		void* m_File    = nullptr;
+		void* m_Mapping = nullptr;
+#endif
+	};
+
+	/**
+	 * @brief Unique temp file next to file. Writers fill it and rename it over file, so readers
+	 *        (and mappings) only ever see whole files and concurrent writers never share a temp file.
+	 */
+	std::filesystem::path temp_path(const std::filesystem::path& file);
+
+	/**
+	 * @brief Has writer fill a temp_path of file, then renames it over file. A failed write
+	 *        never replaces file and never leaves its temp file behind.
+	 */
+	bool write_atomically(const std::filesystem::path& file, const std::function<void(std::ostream&)>& writer);
+
+} // namespace aby::ft
@@ -0,0 +1,85 @@
+#pragma once
+#include <span>
+#include <vector>
+
+#include "FT/common.h"
+
+namespace aby::ft {
+
+	struct Rect {
+		u32 x = 0;
+		u32 y = 0;
+		u32 w = 0;
+		u32 h = 0;
+	};
+
+	/**
+	 * @brief Skyline bottom-left rectangle packer.
+	 */
+	class SkylinePacker {
+	public:
+		SkylinePacker(u32 width, u32 height);
+
+		bool pack(u32 w, u32 h, Rect& out);
+		void reset(u32 width, u32 height);
+
+		u32 width() const;
+		u32 height() const;
+	private:
+		struct Node {
+			u32 x = 0;
+			u32 y = 0;
+			u32 w = 0;
+		};
+
+		bool fits(std::size_t idx, u32 w, u32 h, u32& y) const;
+	private:
+		std::vector<Node> m_Skyline;
+		u32 m_Width;
+		u32 m_Height;
+	};
+
+	/**
+	 * @brief Places rects in arrival order onto page_size x page_size pages, opening the next page
+	 *        when one is full. A rect is final as soon as it is placed, at the cost of the tighter
+	 *        packing layout_atlas gets from seeing every rect first.
+	 */
+	class OnlineAtlasPacker {
+	public:
+		OnlineAtlasPacker(u32 page_size, u32 padding);
+
+		/**
+		 * @return false if the rect is larger than a page.
+		 */
+		bool place(u32 w, u32 h, Rect& rect, u32& page);
+
+		u32 page_count() const;
+		u32 page_size() const;
+	private:
+		SkylinePacker m_Packer;
+		u32 m_PageSize;
+		u32 m_Padding;
+		u32 m_PageCount = 0;
+	};
+
+	struct AtlasLayout {
+		struct Page {
+			u32 width  = 0;
+			u32 height = 0;
+		};
+		std::vector<Page> pages;
+		std::vector<Rect> rects; // Same order as the input sizes.
+		std::vector<u32> page;   // Page index of each rect.
+	};
+
+	/**
+	 * @brief Packs rects (only w/h are read) tallest first into as many pages
+	 *        of at most max_size x max_size as needed. Each page is shrunk to the
+	 *        smallest power of two that holds its rects, or to the size of the
+	 *        largest page if uniform is set (for array textures).
+	 *        Padding is kept between rects, not around the page border.
+	 * @return false if a single rect is larger than max_size x max_size.
+	 */
+	bool layout_atlas(std::span<const Rect> sizes, u32 max_size, u32 padding, bool uniform, AtlasLayout& out);
+
+} // namespace aby::ft
@@ -0,0 +1,46 @@
+#pragma once
+#include <filesystem>
+#include <span>
+#include <vector>
+
+#include "FT/common.h"
+
+namespace aby::ft {
+
+	enum class EPngFilter : u32 {
+		NONE     = 0,
+		SUB      = 1,
+		UP       = 2,
+		AVERAGE  = 3,
+		PAETH    = 4,
+		ADAPTIVE = 5, // Per row, the filter with the smallest sum of absolute residuals (libpng's heuristic).
+	};
+
+	enum class EPngStrategy : u32 {
+		DEFAULT      = 0,
+		FILTERED     = 1, // Favors huffman coding over string matching, suits filtered image rows.
+		HUFFMAN_ONLY = 2,
+		RLE          = 3, // Runs only, fast and good on atlases that are mostly empty.
+	};
+
+	struct PngEncodeCfg {
+		i32 level             = 6; // zlib level, 0 (store) to 9 (smallest).
+		EPngFilter filter     = EPngFilter::UP;
+		EPngStrategy strategy = EPngStrategy::DEFAULT;
+		u32 threads           = 0;  // 0 uses every hardware thread, or only the calling one on a library pool worker. Output does not depend on it.
+		u32 band_rows         = 64; // Rows deflated independently per task, smaller bands scale further but compress worse.
+	};
+
+	/**
+	 * @brief Encodes 8 bit gray (channels 1), gray alpha (2), rgb (3) or rgba (4) rows into a png.
+	 *        Row bands are filtered and deflated in parallel and joined into one zlib stream,
+	 *        every band is primed with the 32KB before it so the ratio stays close to a serial encode.
+	 */
+	std::vector<unsigned char> encode_png(std::span<const unsigned char> pixels, u32 width, u32 height, u32 channels, const PngEncodeCfg& cfg = {});
+
+	/**
+	 * @brief encode_png into a temp file renamed over file.
+	 */
+	bool write_png(const std::filesystem::path& file, std::span<const unsigned char> pixels, u32 width, u32 height, u32 channels, const PngEncodeCfg& cfg = {});
+
+} // namespace aby::ft
@@ -2,33 +2,75 @@
 #include <cstring>
 #include <filesystem>
 #include <memory>
+#include <span>
 #include <vector>
 #include <PrettyPrint/PrettyPrint.h>
 
 #include "FT/common.h"
+#include "FT/mapped_file.h"
 
 namespace aby::ft {
 
 	enum class ESerializeMode {
 		READ,
 		WRITE,
+		MAP, // Read-only view over a memory mapped file, nothing is copied.
 	};
 
 	struct SerializeOpts {
 		std::filesystem::path file;
 		ESerializeMode mode;
+		std::shared_ptr<MappedFile> mapping = nullptr; // MAP mode reads it instead of mapping file again.
 	};
 
 	class Serializer {
 	public:
 		explicit Serializer(const SerializeOpts& opts);
 
-		void save();
+		bool save();
 		void reset();
 		void seek(i64 offset);
 
+		/**
+		 * @brief Moves to offset bytes from the start, at most to the end of the data.
+		 */
+		void seek_to(std::size_t offset);
+
 		void set_mode(ESerializeMode mode);
 
+		/**
+		 * @brief Pads (write) or skips (read) up to the next multiple of alignment.
+		 */
+		void align(std::size_t alignment);
+
+		/**
+		 * @brief Shared ownership of the mapping when in MAP mode, keeps view() spans alive.
+		 */
+		std::shared_ptr<const MappedFile> mapping() const;
+
+		template <typename T>
+		void write_span(std::span<const T> data) {
+			static_assert(std::is_trivially_copyable_v<T>);
+			FT_ASSERT(m_Opts.mode == ESerializeMode::WRITE, "Cannot write when mode is set to read");
+			const auto* bytes = reinterpret_cast<const std::byte*>(data.data());
+			m_Data.insert(m_Data.end(), bytes, bytes + data.size_bytes());
+		}
+
+		/**
+		 * @brief Returns count objects in place, the data must be aligned for T.
+		 */
+		template <typename T>
+		std::span<const T> view(std::size_t count) {
+			static_assert(std::is_trivially_copyable_v<T>);
+			FT_ASSERT(m_Opts.mode != ESerializeMode::WRITE, "Cannot read when mode is set to write");
+			auto data = bytes();
+			FT_ASSERT(m_Offset + count * sizeof(T) <= data.size(), "Out of range");
+			const auto* first = data.data() + m_Offset;
+			FT_ASSERT(reinterpret_cast<std::uintptr_t>(first) % alignof(T) == 0, "Misaligned view");
+			m_Offset += count * sizeof(T);
+			return { reinterpret_cast<const T*>(first), count };
+		}
+
 		template <typename T>
 		void write(const T& data) {
 			FT_ASSERT(m_Opts.mode == ESerializeMode::WRITE, "Cannot write when mode is set to read");
@@ -50,35 +92,39 @@ namespace aby::ft {
 
 		template <typename T>
 		T& read(T& buffer) {
-			FT_ASSERT(m_Opts.mode == ESerializeMode::READ, "Cannot read when mode is set to write");
+			FT_ASSERT(m_Opts.mode != ESerializeMode::WRITE, "Cannot read when mode is set to write");
+			auto data = bytes();
 			if constexpr (std::is_same_v<T, std::string>) {
 				i64 length = 0;
-				std::memcpy(&length, &m_Data[m_Offset], sizeof(length));
+				std::memcpy(&length, &data[m_Offset], sizeof(length));
 				m_Offset += sizeof(length);
-				buffer.assign(reinterpret_cast<const char*>(&m_Data[m_Offset]), length);
+				buffer.assign(reinterpret_cast<const char*>(&data[m_Offset]), length);
 				m_Offset += length;
 			} else if constexpr (std::is_same_v<T, const char*>) {
 				i64 length = 0;
 				constexpr std::byte null{ 0 };
-				while (m_Offset + length < m_Data.size() && m_Data[m_Offset + length] != null) {
+				while (m_Offset + length < data.size() && data[m_Offset + length] != null) {
 					++length;
 				}
-				buffer    = reinterpret_cast<const char*>(&m_Data[m_Offset]);
+				buffer    = reinterpret_cast<const char*>(&data[m_Offset]);
 				m_Offset += length + 1;
 			} else if constexpr (std::is_trivially_constructible_v<T>) {
-				FT_ASSERT(m_Offset + sizeof(T) <= m_Data.size(), "Out of range");
-				std::memcpy(&buffer, &m_Data[m_Offset], sizeof(T));
+				FT_ASSERT(m_Offset + sizeof(T) <= data.size(), "Out of range");
+				std::memcpy(&buffer, &data[m_Offset], sizeof(T));
 				m_Offset += sizeof(T);
 			}
 			return buffer;
 		}
 	protected:
 		void read_file();
+		void map_file();
 		void create_file();
+		std::span<const std::byte> bytes() const;
 	private:
 		SerializeOpts m_Opts;
 		i64 m_Offset;
 		std::vector<std::byte> m_Data;
+		std::shared_ptr<MappedFile> m_Map;
 	};
 
 } // namespace aby::ft
@@ -0,0 +1,58 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "FT/common.h"
+
+namespace aby::ft {
+
+	/**
+	 * @brief Fixed size worker pool, tasks run in submission order.
+	 *        The destructor finishes every queued task before joining.
+	 */
+	class ThreadPool {
+	public:
+		explicit ThreadPool(u32 threads = 0); // 0 uses every hardware thread.
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&)            = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		template <typename F>
+		auto submit(F&& fn) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+			using R = std::invoke_result_t<std::decay_t<F>>;
+			std::packaged_task<R()> task(std::forward<F>(fn));
+			auto future = task.get_future();
+			{
+				std::lock_guard lock(m_Mutex);
+				m_Tasks.emplace_back(std::move(task));
+			}
+			m_Signal.notify_one();
+			return future;
+		}
+
+		u32 size() const;
+
+		/**
+		 * @brief Whether the calling thread is a worker of any pool. Work that would fan out over
+		 *        every core runs inline there instead, the pool already keeps the cores busy.
+		 */
+		static bool on_worker();
+	private:
+		void run();
+	private:
+		std::vector<std::thread> m_Workers;
+		std::deque<std::move_only_function<void()>> m_Tasks;
+		std::mutex m_Mutex;
+		std::condition_variable m_Signal;
+		bool m_Stop = false;
+		static inline thread_local bool s_OnWorker = false;
+	};
+
+} // namespace aby::ft
@@ -0,0 +1,139 @@
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+#include <vector>
+#include <PrettyPrint/PrettyPrint.h>
+#include "FT/abyft.h"
+#include "FT/kernels.h"
+#include "FT/png_encoder.h"
+#include <stb/stb_image_write.h>
+
+namespace aby::ft::bench {
+
+	using clock = std::chrono::steady_clock;
+
+	template <typename Fn>
+	double best_ms(u32 iterations, Fn&& fn) {
+		double best = 0.0;
+		for (u32 i = 0; i < iterations; i++) {
+			auto start = clock::now();
+			fn();
+			double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+			best      = i == 0 ? ms : std::min(best, ms);
+		}
+		return best;
+	}
+
+	void expand(u32 size) {
+		std::vector<unsigned char> src(std::size_t(size) * size);
+		std::vector<unsigned char> dst(src.size() * 4);
+		for (std::size_t i = 0; i < src.size(); i++) {
+			src[i] = static_cast<unsigned char>(i * 31);
+		}
+
+		double scalar = best_ms(10, [&] { expand_r8_rgba8(src.data(), dst.data(), src.size(), EKernelIsa::SCALAR); });
+		std::string info = std::format("  Expand r8 -> rgba8, {0}x{0} atlas\n", size);
+		for (EKernelIsa isa : { EKernelIsa::SCALAR, EKernelIsa::SSE2, EKernelIsa::AVX2, EKernelIsa::NEON }) {
+			if (!kernel_supported(isa)) continue;
+			double ms = best_ms(10, [&] { expand_r8_rgba8(src.data(), dst.data(), src.size(), isa); });
+			info += std::format("    {:<8} {:8.3f}ms {:7.2f} GB/s {:5.2f}x\n", kernel_isa_name(isa), ms, dst.size() / ms * 1e-6, scalar / ms);
+		}
+		util::pretty_print(info, "AbyssFTBench");
+	}
+
+	void blit(u32 size) {
+		// Glyph sized rects blitted over a whole atlas, the pattern of atlas assembly.
+		constexpr u32 GLYPH = 24;
+		std::vector<unsigned char> glyph(GLYPH * GLYPH, 0x80);
+		std::vector<unsigned char> atlas(std::size_t(size) * size);
+		auto run = [&](bool kernel) {
+			for (u32 y = 0; y + GLYPH <= size; y += GLYPH) {
+				for (u32 x = 0; x + GLYPH <= size; x += GLYPH) {
+					unsigned char* dst = &atlas[std::size_t(y) * size + x];
+					if (kernel) {
+						blit_rows(glyph.data(), GLYPH, dst, size, GLYPH, GLYPH);
+						continue;
+					}
+					for (u32 row = 0; row < GLYPH; row++) {
+						for (u32 col = 0; col < GLYPH; col++) {
+							dst[std::size_t(row) * size + col] = glyph[row * GLYPH + col];
+						}
+					}
+				}
+			}
+		};
+		double loop   = best_ms(10, [&] { run(false); });
+		double kernel = best_ms(10, [&] { run(true); });
+		util::pretty_print(std::format("  Blit {0}x{0} glyphs into a {1}x{1} atlas\n    per texel {2:8.3f}ms\n    blit_rows {3:8.3f}ms {4:5.2f}x\n", GLYPH, size, loop, kernel, loop / kernel), "AbyssFTBench");
+	}
+
+	void png(u32 size) {
+		// A mostly empty atlas of glyph sized blobs, the shape of a baked page.
+		constexpr u32 GLYPH = 24;
+		std::vector<unsigned char> atlas(std::size_t(size) * size);
+		for (u32 y = 0; y + GLYPH <= size; y += GLYPH + 2) {
+			for (u32 x = 0; x + GLYPH <= size; x += GLYPH + 2) {
+				for (u32 row = 4; row < GLYPH - 4; row++) {
+					for (u32 col = 6 + (row + x / GLYPH) % 5; col < GLYPH - 6; col++) {
+						atlas[std::size_t(y + row) * size + x + col] = static_cast<unsigned char>(col * 40 + row * 3);
+					}
+				}
+			}
+		}
+
+		std::vector<unsigned char> out;
+		auto collect = [](void* context, void* data, int length) {
+			auto* bytes = static_cast<unsigned char*>(data);
+			static_cast<std::vector<unsigned char>*>(context)->assign(bytes, bytes + length);
+		};
+		double stb = best_ms(3, [&] { stbi_write_png_to_func(collect, &out, size, size, 1, atlas.data(), size); });
+		std::string info = std::format("  Png r8, {0}x{0} atlas\n    {1:<28} {2:8.3f}ms {3:9} bytes\n", size, "stb_image_write", stb, out.size());
+
+		struct Case {
+			const char* name;
+			PngEncodeCfg cfg;
+		};
+		const Case cases[] = {
+			{ "level 6, up, 1 thread", { .level = 6, .threads = 1 } },
+			{ "level 6, up", { .level = 6 } },
+			{ "level 1, up", { .level = 1 } },
+			{ "level 9, up", { .level = 9 } },
+			{ "level 6, adaptive", { .level = 6, .filter = EPngFilter::ADAPTIVE } },
+			{ "level 6, up, rle", { .level = 6, .strategy = EPngStrategy::RLE } },
+			{ "level 6, none, rle", { .level = 6, .filter = EPngFilter::NONE, .strategy = EPngStrategy::RLE } },
+		};
+		for (const Case& c : cases) {
+			double ms = best_ms(3, [&] { out = encode_png(atlas, size, size, 1, c.cfg); });
+			info += std::format("    {:<28} {:8.3f}ms {:9} bytes {:5.2f}x\n", c.name, ms, out.size(), stb / ms);
+		}
+		util::pretty_print(info, "AbyssFTBench");
+	}
+
+	void bake(const std::filesystem::path& font) {
+		FontCfg cfg{
+			.range   = { 32, 0x500 },
+			.path    = font,
+			.format  = EAtlasFormat::RGBA8,
+		};
+		double ms = best_ms(3, [&] {
+			std::filesystem::remove_all("./BenchCache");
+			Library::get().create_font_data("./BenchCache", cfg);
+		});
+		std::filesystem::remove_all("./BenchCache");
+		util::pretty_print(std::format("  Bake {} (32..0x500, rgba8)\n    {:8.3f}ms\n", font.filename().string(), ms), "AbyssFTBench");
+	}
+
+} // namespace aby::ft::bench
+
+int main(int argc, char** argv) {
+	FT_STATUS("Kernel instruction set: {}", aby::ft::kernel_isa_name(aby::ft::kernel_isa()));
+	aby::ft::bench::expand(4096);
+	aby::ft::bench::blit(4096);
+	aby::ft::bench::png(4096);
+
+	std::filesystem::path font = std::filesystem::path(argv[0]).parent_path() / "AbyssFreetypeTests" / "Fonts" / "IBMPlexMono" / "IBMPlexMono-Regular.ttf";
+	if (std::filesystem::exists(font)) {
+		aby::ft::bench::bake(font);
+	}
+	return 0;
+}
@@ -1,7 +1,21 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <filesystem>
+#include <fstream>
 #include <optional>
+#include <thread>
 #include <PrettyPrint/PrettyPrint.h>
 #include "FT/abyft.h"
+#include "FT/atlas.h"
+#include "FT/cache_manifest.h"
+#include "FT/dynamic_atlas.h"
+#include "FT/kernels.h"
+#include "FT/packer.h"
+#include "FT/png_encoder.h"
+#include "FT/serializer.h"
+#include "FT/thread_pool.h"
+#include <zlib.h>
 
 #ifdef _WIN32
 #	include <windows.h>
@@ -42,13 +56,1215 @@ namespace aby::ft::test {
 			FT_ERROR("Font: {} is supposed to have name of {}", FONT.string(), cfg.path.filename().string());
 		}
 
-		if (!std::filesystem::exists(data.value().png)) {
-			FT_ERROR("Font: {} failed to output PNG file", FONT.string());
+		for (const auto& page : data.value().pages) {
+			if (!std::filesystem::exists(page.png)) {
+				FT_ERROR("Font: {} failed to output PNG file {}", FONT.string(), page.png.string());
+			}
 		}
 
 		return data;
 	}
 
+	bool find_records(const FontData& data) {
+		if (data.records.size() != data.glyphs.size()) {
+			FT_ERROR("Font has {} records but {} glyphs", data.records.size(), data.glyphs.size());
+			return false;
+		}
+		for (const auto& [c, g] : data.glyphs) {
+			const Glyph* record = data.find(c);
+			if (!record || record->codepoint != c || std::memcmp(record, &g, sizeof(Glyph)) != 0) {
+				FT_ERROR("Record for {} does not match its glyph", static_cast<u32>(c));
+				return false;
+			}
+		}
+		return data.find(U'\0') == nullptr;
+	}
+
+	bool dense_lookup(const std::filesystem::path& font) {
+		FontCfg cfg{
+			.pt     = 14,
+			.range  = { 32, 128 },
+			.path   = font,
+			.lookup = EGlyphLookup::DENSE,
+		};
+		FontData dense  = Library::get().create_font_data(CACHE_DIR, cfg);
+		FontData sorted = dense;
+		sorted.lookup   = EGlyphLookup::SORTED;
+		if (dense.lookup != EGlyphLookup::DENSE || dense.dense.empty()) {
+			FT_ERROR("Font: {} did not build a dense table", font.string());
+			return false;
+		}
+		for (char32_t c = 0; c < 512; c++) {
+			if (dense.find(c) != (sorted.find(c) ? &dense.dense[c] : nullptr)) {
+				FT_ERROR("Dense lookup of {} does not match sorted lookup", static_cast<u32>(c));
+				return false;
+			}
+			if (!sorted.find(c) && dense.dense[c].codepoint != INVALID_CODEPOINT) {
+				FT_ERROR("Missing glyph {} is not the sentinel", static_cast<u32>(c));
+				return false;
+			}
+		}
+
+		// Records are only dense indexed in order, a cache whose records are not is baked again.
+		const Glyph unsorted[] = { Glyph{ .codepoint = 10 }, Glyph{ .codepoint = 100000 }, Glyph{ .codepoint = 12 } };
+		if (DenseGlyphs(unsorted).size() != 3 || DenseGlyphs(unsorted).find(100000)) {
+			FT_ERROR("Dense table of unsorted records is wrong");
+			return false;
+		}
+		std::filesystem::remove_all(CACHE_DIR / "UnsortedDense");
+		Library::get().create_font_data(CACHE_DIR / "UnsortedDense", cfg);
+		auto bin = CACHE_DIR / "UnsortedDense" / "Fonts" / std::format("{}_{:016x}.bin", font.filename().string(), dense.key);
+		{
+			std::fstream file(bin, std::ios::binary | std::ios::in | std::ios::out);
+			u64 glyph_offset = 0;
+			file.seekg(24); // GlyphCacheHeader::glyph_offset
+			file.read(reinterpret_cast<char*>(&glyph_offset), sizeof(glyph_offset));
+			Glyph first[2];
+			file.seekg(glyph_offset);
+			file.read(reinterpret_cast<char*>(first), sizeof(first));
+			std::swap(first[0], first[1]);
+			file.seekp(glyph_offset);
+			file.write(reinterpret_cast<const char*>(first), sizeof(first));
+		}
+		FontData reloaded = Library::get().create_font_data(CACHE_DIR / "UnsortedDense", cfg);
+		if (reloaded.records.size() != dense.records.size() || std::memcmp(reloaded.records.data(), dense.records.data(), dense.records.size_bytes()) != 0) {
+			FT_ERROR("Font: {} out of order cached glyphs were loaded", font.string());
+			return false;
+		}
+		return true;
+	}
+
+	bool perfect_hash_lookup(const std::filesystem::path& font) {
+		// Sparse synthetic set, latin + greek + cyrillic + cjk like spread.
+		std::vector<Glyph> records;
+		for (char32_t c = 0; c < 0x30000; c += 1 + (c * 2654435761u) % 97) {
+			records.push_back(Glyph{ .advance = static_cast<u32>(c), .codepoint = c });
+		}
+		PerfectGlyphHash hash(records);
+		for (const Glyph& glyph : records) {
+			const Glyph* found = hash.find(glyph.codepoint);
+			if (!found || found->advance != glyph.codepoint) {
+				FT_ERROR("Perfect hash lost codepoint {}", static_cast<u32>(glyph.codepoint));
+				return false;
+			}
+		}
+		for (char32_t c = 1; c < 0x30000; c += 2) {
+			const Glyph* found = hash.find(c);
+			if (found && found->codepoint != c) {
+				FT_ERROR("Perfect hash returned {} for {}", static_cast<u32>(found->codepoint), static_cast<u32>(c));
+				return false;
+			}
+		}
+
+		FontCfg cfg{
+			.pt     = 14,
+			.range  = { 32, 128 },
+			.path   = font,
+			.lookup = EGlyphLookup::PERFECT_HASH,
+		};
+		FontData data   = Library::get().create_font_data(CACHE_DIR, cfg);
+		FontData sorted = data;
+		sorted.lookup   = EGlyphLookup::SORTED;
+		if (data.hash.empty()) {
+			FT_ERROR("Font: {} did not load a perfect hash", font.string());
+			return false;
+		}
+		for (char32_t c = 0; c < 512; c++) {
+			if (data.find(c) != sorted.find(c)) {
+				FT_ERROR("Perfect hash lookup of {} does not match sorted lookup", static_cast<u32>(c));
+				return false;
+			}
+		}
+
+		// The slot table ends the glyph file, an out of range slot must be caught on load, not in find.
+		std::vector<u32> bad_slots(hash.slots().begin(), hash.slots().end());
+		bad_slots.back() = static_cast<u32>(records.size());
+		if (!PerfectGlyphHash::valid(records.size(), hash.seeds(), hash.slots()) || PerfectGlyphHash::valid(records.size(), hash.seeds(), bad_slots)) {
+			FT_ERROR("Perfect hash validation is wrong");
+			return false;
+		}
+		std::filesystem::remove_all(CACHE_DIR / "CorruptHash");
+		Library::get().create_font_data(CACHE_DIR / "CorruptHash", cfg);
+		auto bin = CACHE_DIR / "CorruptHash" / "Fonts" / std::format("{}_{:016x}.bin", font.filename().string(), data.key);
+		{
+			std::fstream file(bin, std::ios::binary | std::ios::in | std::ios::out);
+			file.seekp(-static_cast<std::streamoff>(sizeof(u32)), std::ios::end);
+			u32 slot = ~0u;
+			file.write(reinterpret_cast<const char*>(&slot), sizeof(slot));
+		}
+		FontData rebaked = Library::get().create_font_data(CACHE_DIR / "CorruptHash", cfg);
+		for (char32_t c = 0; c < 512; c++) {
+			if (rebaked.find(c) ? !sorted.find(c) || rebaked.find(c)->advance != sorted.find(c)->advance : sorted.find(c) != nullptr) {
+				FT_ERROR("Font: {} corrupt hash was used for {}", font.string(), static_cast<u32>(c));
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool corrupt_glyph_count(const std::filesystem::path& font) {
+		// A glyph count whose record bytes wrap past the file size must be rejected, not viewed out of bounds.
+		FontCfg cfg{ .pt = 14, .range = { 32, 128 }, .path = font };
+		std::filesystem::remove_all(CACHE_DIR / "CorruptCount");
+		FontData data = Library::get().create_font_data(CACHE_DIR / "CorruptCount", cfg);
+		auto bin      = CACHE_DIR / "CorruptCount" / "Fonts" / std::format("{}_{:016x}.bin", font.filename().string(), data.key);
+		{
+			std::fstream file(bin, std::ios::binary | std::ios::in | std::ios::out);
+			file.seekp(16); // GlyphCacheHeader::glyph_count
+			u64 count = ~0ull / sizeof(Glyph) + 1;
+			file.write(reinterpret_cast<const char*>(&count), sizeof(count));
+		}
+		FontData rebaked = Library::get().create_font_data(CACHE_DIR / "CorruptCount", cfg);
+		if (rebaked.records.size() != data.records.size() || std::memcmp(rebaked.records.data(), data.records.data(), data.records.size_bytes()) != 0) {
+			FT_ERROR("Font: {} corrupt glyph count was loaded ({} glyphs)", font.string(), rebaked.records.size());
+			return false;
+		}
+		return true;
+	}
+
+	bool parallel_raster(const std::filesystem::path& font) {
+		FontCfg cfg{
+			.pt    = 14,
+			.range = { 32, 0x500 },
+			.path  = font,
+		};
+		std::filesystem::remove_all(CACHE_DIR / "Serial");
+		std::filesystem::remove_all(CACHE_DIR / "Parallel");
+		FontData serial = Library::get().create_font_data(CACHE_DIR / "Serial", cfg);
+		cfg.threads     = 4;
+		FontData parallel = Library::get().create_font_data(CACHE_DIR / "Parallel", cfg);
+
+		if (serial.records.size() != parallel.records.size() || std::memcmp(serial.records.data(), parallel.records.data(), serial.records.size_bytes()) != 0) {
+			FT_ERROR("Font: {} parallel glyphs differ from serial glyphs", font.string());
+			return false;
+		}
+		if (serial.pages.size() != parallel.pages.size()) {
+			FT_ERROR("Font: {} parallel page count differs from serial", font.string());
+			return false;
+		}
+		for (std::size_t i = 0; i < serial.pages.size(); i++) {
+			MappedAtlas a(serial.pages[i].raw);
+			MappedAtlas b(parallel.pages[i].raw);
+			if (!a.is_open() || !b.is_open() || a.pixels().size() != b.pixels().size() || std::memcmp(a.pixels().data(), b.pixels().data(), a.pixels().size()) != 0) {
+				FT_ERROR("Font: {} parallel page {} differs from serial", font.string(), i);
+				return false;
+			}
+		}
+
+		// threads = 0 on a pool worker rasterizes on that worker alone, the glyphs are the same.
+		std::filesystem::remove_all(CACHE_DIR / "PooledRaster");
+		cfg.threads     = 0;
+		FontData pooled = Library::get().create_font_data_async(CACHE_DIR / "PooledRaster", cfg).get();
+		if (pooled.records.size() != serial.records.size() || std::memcmp(pooled.records.data(), serial.records.data(), serial.records.size_bytes()) != 0) {
+			FT_ERROR("Font: {} glyphs rasterized on a pool worker differ from serial glyphs", font.string());
+			return false;
+		}
+		return true;
+	}
+
+	bool batch_load(const std::filesystem::path& font) {
+		std::vector<FontCfg> cfgs;
+		for (u32 pt : { 10, 14, 18, 24 }) {
+			for (CharRange range : { CharRange{ 32, 128 }, CharRange{ 128, 512 } }) {
+				cfgs.push_back(FontCfg{ .pt = pt, .range = range, .path = font });
+			}
+		}
+		std::filesystem::remove_all(CACHE_DIR / "Batch");
+		std::filesystem::remove_all(CACHE_DIR / "Sequential");
+		std::vector<FontData> batch = Library::get().create_font_data_batch(CACHE_DIR / "Batch", cfgs);
+		if (batch.size() != cfgs.size()) {
+			FT_ERROR("Batch returned {} fonts for {} configs", batch.size(), cfgs.size());
+			return false;
+		}
+		for (std::size_t i = 0; i < cfgs.size(); i++) {
+			FontData data = Library::get().create_font_data(CACHE_DIR / "Sequential", cfgs[i]);
+			if (data.records.size() != batch[i].records.size() || std::memcmp(data.records.data(), batch[i].records.data(), data.records.size_bytes()) != 0) {
+				FT_ERROR("Batch font {} (pt {}) differs from a sequential load", i, cfgs[i].pt);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool map_raw_atlas(const FontData& data) {
+		for (const auto& page : data.pages) {
+			MappedAtlas atlas(page.raw);
+			if (!atlas.is_open()) {
+				FT_ERROR("Failed to map raw atlas {}", page.raw.string());
+				return false;
+			}
+			const RawAtlasHeader& header = atlas.header();
+			if (header.width != page.width || header.height != page.height || header.format != data.format) {
+				FT_ERROR("Raw atlas {} header does not match the page", page.raw.string());
+				return false;
+			}
+			if (atlas.pixels().size() != std::size_t(page.width) * page.height * texel_size(data.format)) {
+				FT_ERROR("Raw atlas {} has the wrong pixel count", page.raw.string());
+				return false;
+			}
+		}
+
+		// Headers whose pixels would reach past the mapping are rejected.
+		std::filesystem::create_directories(CACHE_DIR / "CorruptAtlas");
+		auto file = CACHE_DIR / "CorruptAtlas" / "page.atlas";
+		const RawAtlasHeader corrupt[] = {
+			RawAtlasHeader{ .width = 4, .height = 4, .format = EAtlasFormat::R8, .row_pitch = 4, .data_offset = ~u64(0) - 8 }, // Wraps the old sum.
+			RawAtlasHeader{ .width = 4, .height = 2, .format = EAtlasFormat::R8, .row_pitch = 1u << 31 },                      // Truncated.
+			RawAtlasHeader{ .width = 4, .height = 4, .format = EAtlasFormat::RGBA8, .row_pitch = 4 },                          // Rows too short.
+		};
+		for (const RawAtlasHeader& header : corrupt) {
+			{
+				std::vector<char> bytes(64 + 64, 0);
+				std::memcpy(bytes.data(), &header, sizeof(header));
+				std::ofstream(file, std::ios::binary | std::ios::trunc).write(bytes.data(), bytes.size());
+			}
+			if (MappedAtlas(file).is_open()) {
+				FT_ERROR("Corrupt raw atlas (pitch {}, offset {}) was mapped", header.row_pitch, header.data_offset);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool face_cache(const std::filesystem::path& font) {
+		// The second pt 14 bake reuses the cached face after it was resized to 24, it must match the first.
+		std::filesystem::remove_all(CACHE_DIR / "FaceCacheA");
+		std::filesystem::remove_all(CACHE_DIR / "FaceCacheB");
+		FontData first = Library::get().create_font_data(CACHE_DIR / "FaceCacheA", FontCfg{ .pt = 14, .path = font });
+		FontData other = Library::get().create_font_data(CACHE_DIR / "FaceCacheA", FontCfg{ .pt = 24, .path = font });
+		FontData again = Library::get().create_font_data(CACHE_DIR / "FaceCacheB", FontCfg{ .pt = 14, .path = font });
+		if (first.records.empty() || first.records.size() != again.records.size() ||
+		    std::memcmp(first.records.data(), again.records.data(), first.records.size_bytes()) != 0 || first.text_height != again.text_height)
+		{
+			FT_ERROR("Font: {} baked from a cached face differs", font.string());
+			return false;
+		}
+		if (other.text_height <= first.text_height) {
+			FT_ERROR("Font: {} cached face was not resized", font.string());
+			return false;
+		}
+		return true;
+	}
+
+	bool mapped_font(const std::filesystem::path& font) {
+		// Faces opened from the shared mapping must bake exactly what FreeType's own file reads bake.
+		std::filesystem::remove_all(CACHE_DIR / "MappedFont");
+		std::filesystem::remove_all(CACHE_DIR / "StreamedFont");
+		FontData mapped   = Library::get().create_font_data(CACHE_DIR / "MappedFont", FontCfg{ .pt = 16, .path = font, .map_font = true, .threads = 4 });
+		FontData streamed = Library::get().create_font_data(CACHE_DIR / "StreamedFont", FontCfg{ .pt = 16, .path = font, .map_font = false });
+		if (mapped.records.empty() || mapped.records.size() != streamed.records.size() ||
+		    std::memcmp(mapped.records.data(), streamed.records.data(), mapped.records.size_bytes()) != 0)
+		{
+			FT_ERROR("Font: {} baked from a mapped file differs", font.string());
+			return false;
+		}
+		return true;
+	}
+
+	bool cache_key(const std::filesystem::path& font) {
+		// Keys follow the font bytes and the bake parameters, not the path.
+		std::filesystem::remove_all(CACHE_DIR / "CacheKey");
+		std::filesystem::create_directories(CACHE_DIR / "CacheKey" / "Copy");
+		auto copy = CACHE_DIR / "CacheKey" / "Copy" / font.filename();
+		std::filesystem::copy_file(font, copy);
+
+		FontData base  = Library::get().create_font_data(CACHE_DIR / "CacheKey", FontCfg{ .pt = 14, .path = font });
+		FontData dpi   = Library::get().create_font_data(CACHE_DIR / "CacheKey", FontCfg{ .pt = 14, .dpi = { 144.f, 144.f }, .path = font });
+		FontData moved = Library::get().create_font_data(CACHE_DIR / "CacheKey", FontCfg{ .pt = 14, .path = copy });
+		if (base.key == 0 || base.key == dpi.key || dpi.text_height <= base.text_height) {
+			FT_ERROR("Font: {} DPI change did not produce a new cache entry", font.string());
+			return false;
+		}
+		if (moved.key != base.key) {
+			FT_ERROR("Font: {} copied to another path got a different key", font.string());
+			return false;
+		}
+		{
+			std::ofstream out(copy, std::ios::binary | std::ios::app);
+			out.put('\0');
+		}
+		FontData edited = Library::get().create_font_data(CACHE_DIR / "CacheKey", FontCfg{ .pt = 14, .path = copy });
+		if (edited.key == base.key) {
+			FT_ERROR("Font: {} edited font file kept its key", font.string());
+			return false;
+		}
+
+		// Replacing the file must not bake the new key from a face that still holds the old font.
+		// Doubling the ascender (hhea, and OS/2 for USE_TYPO_METRICS) is enough to show up in text_height.
+		std::vector<char> bytes(std::filesystem::file_size(copy));
+		std::ifstream(copy, std::ios::binary).read(bytes.data(), bytes.size());
+		auto be16 = [&](std::size_t at) { return u32(static_cast<unsigned char>(bytes[at])) << 8 | static_cast<unsigned char>(bytes[at + 1]); };
+		auto be32 = [&](std::size_t at) { return be16(at) << 16 | be16(at + 2); };
+		for (u32 i = 0; i < be16(4); i++) {
+			std::size_t record = 12 + i * 16;
+			bool hhea = std::memcmp(&bytes[record], "hhea", 4) == 0;
+			if (!hhea && std::memcmp(&bytes[record], "OS/2", 4) != 0) continue;
+			std::size_t ascender = be32(record + 8) + (hhea ? 4 : 68);
+			u32 doubled          = be16(ascender) * 2;
+			bytes[ascender]      = static_cast<char>(doubled >> 8);
+			bytes[ascender + 1]  = static_cast<char>(doubled);
+		}
+		auto mtime = std::filesystem::last_write_time(copy);
+		std::ofstream(copy, std::ios::binary | std::ios::trunc).write(bytes.data(), bytes.size());
+		std::filesystem::last_write_time(copy, mtime + std::chrono::seconds(2)); // Same size, coarse mtimes may not move.
+		FontData replaced = Library::get().create_font_data(CACHE_DIR / "CacheKey", FontCfg{ .pt = 14, .path = copy });
+		if (replaced.key == edited.key || replaced.text_height <= edited.text_height) {
+			FT_ERROR("Font: {} replaced font file was baked from the old face", font.string());
+			return false;
+		}
+
+		// Unreadable fonts fail the load instead of sharing one key.
+		FontData missing = Library::get().create_font_data(CACHE_DIR / "CacheKey", FontCfg{ .pt = 14, .path = CACHE_DIR / "CacheKey" / "missing.ttf" });
+		if (!missing.records.empty() || missing.key != 0) {
+			FT_ERROR("Font: a missing font file produced a font");
+			return false;
+		}
+		return true;
+	}
+
+	bool cache_bundle(const std::filesystem::path& font) {
+		// A bundle must hold the same glyphs and texels as the separate files, baked or mapped back.
+		std::filesystem::remove_all(CACHE_DIR / "Files");
+		std::filesystem::remove_all(CACHE_DIR / "Bundle");
+		FontCfg cfg{ .pt = 14, .range = { 32, 0x500 }, .path = font, .max_page_size = 256 };
+		FontData files = Library::get().create_font_data(CACHE_DIR / "Files", cfg);
+		cfg.cache_layout = ECacheLayout::BUNDLE;
+		FontData baked  = Library::get().create_font_data(CACHE_DIR / "Bundle", cfg);
+		FontData mapped = Library::get().create_font_data(CACHE_DIR / "Bundle", cfg);
+
+		for (const FontData* data : { &baked, &mapped }) {
+			if (data->records.size() != files.records.size() || std::memcmp(data->records.data(), files.records.data(), files.records.size_bytes()) != 0) {
+				FT_ERROR("Font: {} bundled glyphs differ from the cache files", font.string());
+				return false;
+			}
+			if (data->pages.size() != files.pages.size() || files.pages.size() < 2) {
+				FT_ERROR("Font: {} bundled page count differs from the cache files", font.string());
+				return false;
+			}
+			for (std::size_t i = 0; i < files.pages.size(); i++) {
+				MappedAtlas atlas(files.pages[i].raw);
+				const auto& pixels = data->pages[i].pixels;
+				if (!atlas.is_open() || pixels.size() != atlas.pixels().size() || std::memcmp(pixels.data(), atlas.pixels().data(), pixels.size()) != 0) {
+					FT_ERROR("Font: {} bundled page {} differs from the raw atlas", font.string(), i);
+					return false;
+				}
+			}
+		}
+		if (baked.storage == mapped.storage) {
+			FT_ERROR("Font: {} bundle was not loaded from the cache", font.string());
+			return false;
+		}
+		auto entries = std::count_if(std::filesystem::directory_iterator(CACHE_DIR / "Bundle" / "Fonts"), std::filesystem::directory_iterator(), [](const auto& entry) {
+			return entry.path().filename() != "manifest.bin";
+		});
+		if (entries != 1) {
+			FT_ERROR("Bundle cache holds {} files, expected 1", entries);
+			return false;
+		}
+		return true;
+	}
+
+	bool cache_manifest(const std::filesystem::path& font) {
+		std::filesystem::remove_all(CACHE_DIR / "Manifest");
+		auto dir      = CACHE_DIR / "Manifest" / "Fonts";
+		FontData a    = Library::get().create_font_data(CACHE_DIR / "Manifest", FontCfg{ .pt = 12, .path = font });
+		FontData b    = Library::get().create_font_data(CACHE_DIR / "Manifest", FontCfg{ .pt = 14, .path = font, .cache_layout = ECacheLayout::BUNDLE });
+		FontData warm = Library::get().create_font_data(CACHE_DIR / "Manifest", FontCfg{ .pt = 12, .path = font });
+
+		CacheManifest manifest(dir);
+		for (const FontData* data : { &a, &b }) {
+			auto entry = manifest.find(data->key);
+			if (!entry || entry->glyph_count != data->records.size() || entry->pages.size() != data->pages.size() ||
+			    entry->pages[0].width != data->pages[0].width || (entry->layout == ECacheLayout::BUNDLE) == (entry->pages[0].offset == 0))
+			{
+				FT_ERROR("Cache manifest does not list {:016x}", data->key);
+				return false;
+			}
+			auto ext = entry->layout == ECacheLayout::BUNDLE ? ".abft" : ".bin";
+			auto file = dir / std::format("{}_{:016x}{}", font.filename().string(), data->key, ext);
+			if (entry->size != std::filesystem::file_size(file)) {
+				FT_ERROR("Cache manifest size of {} is {}, the file has {}", file.string(), entry->size, std::filesystem::file_size(file));
+				return false;
+			}
+		}
+		if (warm.key != a.key || warm.storage == a.storage) {
+			FT_ERROR("Font: {} listed entry was not loaded from the cache", font.string());
+			return false;
+		}
+
+		// Entries another process recorded meanwhile survive the next update.
+		manifest.insert(CacheManifestEntry{ .key = 42, .size = 1 });
+		Library::get().create_font_data(CACHE_DIR / "Manifest", FontCfg{ .pt = 16, .path = font });
+		CacheManifest merged(dir);
+		if (merged.size() != 4 || !merged.find(42)) {
+			FT_ERROR("Cache manifest lost entries while merging, {} listed", merged.size());
+			return false;
+		}
+
+		// A listed entry still gets the page files the current config asks for when they were never written.
+		FontCfg no_png{ .pt = 18, .path = font, .write_png = false };
+		Library::get().create_font_data(CACHE_DIR / "Manifest", no_png);
+		no_png.write_png = true;
+		FontData with_png = Library::get().create_font_data(CACHE_DIR / "Manifest", no_png);
+		if (with_png.pages.empty() || !std::filesystem::exists(with_png.pages[0].png)) {
+			FT_ERROR("Font: {} listed entry returned a png that was never written", font.string());
+			return false;
+		}
+		auto entry = CacheManifest(dir).find(with_png.key);
+		if (!entry || !entry->png || !entry->raw) {
+			FT_ERROR("Cache manifest does not list the page files of {:016x}", with_png.key);
+			return false;
+		}
+
+		// A listed hit is answered by the manifest, not even a page file deleted behind its back is probed.
+		std::filesystem::remove(with_png.pages[0].raw);
+		FontData listed = Library::get().create_font_data(CACHE_DIR / "Manifest", no_png);
+		if (listed.records.empty() || std::filesystem::exists(listed.pages[0].raw)) {
+			FT_ERROR("Font: {} listed entry was probed or baked again", font.string());
+			return false;
+		}
+
+		// Both layouts of one config are separate entries, warm loads of either leave the manifest alone.
+		FontCfg alternate{ .pt = 22, .path = font };
+		FontData as_files = Library::get().create_font_data(CACHE_DIR / "Manifest", alternate);
+		alternate.cache_layout = ECacheLayout::BUNDLE;
+		FontData as_bundle = Library::get().create_font_data(CACHE_DIR / "Manifest", alternate);
+		if (as_files.key == as_bundle.key || !CacheManifest(dir).find(as_files.key) || !CacheManifest(dir).find(as_bundle.key)) {
+			FT_ERROR("Font: {} layouts of one config share a manifest entry", font.string());
+			return false;
+		}
+		auto file    = dir / "manifest.bin";
+		auto written = std::filesystem::last_write_time(file) - std::chrono::hours(1); // A rewrite renames a new file over it.
+		std::filesystem::last_write_time(file, written);
+		for (ECacheLayout layout : { ECacheLayout::FILES, ECacheLayout::BUNDLE, ECacheLayout::FILES, ECacheLayout::BUNDLE }) {
+			alternate.cache_layout = layout;
+			Library::get().create_font_data(CACHE_DIR / "Manifest", alternate);
+		}
+		if (std::filesystem::last_write_time(file) != written) {
+			FT_ERROR("Font: {} alternating layouts rewrote the cache manifest", font.string());
+			return false;
+		}
+
+		// Counts that would wrap the size check make the manifest empty, not a huge allocation.
+		std::filesystem::remove_all(CACHE_DIR / "CorruptManifest");
+		std::filesystem::create_directories(CACHE_DIR / "CorruptManifest");
+		{
+			const u32 ids[]    = { CACHE_MANIFEST_MAGIC, CACHE_MANIFEST_VERSION };
+			const u64 counts[] = { u64(1) << 60, u64(0) - (u64(1) << 62) };
+			std::ofstream out(CACHE_DIR / "CorruptManifest" / "manifest.bin", std::ios::binary);
+			out.write(reinterpret_cast<const char*>(ids), sizeof(ids));
+			out.write(reinterpret_cast<const char*>(counts), sizeof(counts));
+		}
+		if (CacheManifest(CACHE_DIR / "CorruptManifest").size() != 0) {
+			FT_ERROR("Corrupt cache manifest was read");
+			return false;
+		}
+		return true;
+	}
+
+	bool async_load(const std::filesystem::path& font) {
+		std::filesystem::remove_all(CACHE_DIR / "Async");
+		std::filesystem::remove_all(CACHE_DIR / "Cancelled");
+		FontCfg cfg{ .pt = 20, .path = font };
+		auto pending = Library::get().create_font_data_async(CACHE_DIR / "Async", cfg);
+
+		std::stop_source cancel;
+		cancel.request_stop();
+		FontData cancelled = Library::get().create_font_data_async(CACHE_DIR / "Cancelled", cfg, cancel.get_token()).get();
+		FontData loaded    = pending.get();
+		FontData expected  = Library::get().create_font_data(CACHE_DIR / "Async", cfg);
+		if (loaded.records.empty() || loaded.records.size() != expected.records.size() ||
+		    std::memcmp(loaded.records.data(), expected.records.data(), expected.records.size_bytes()) != 0)
+		{
+			FT_ERROR("Font: {} async load differs from a blocking load", font.string());
+			return false;
+		}
+		if (!cancelled.records.empty() || !cancelled.pages.empty() || std::filesystem::exists(CACHE_DIR / "Cancelled")) {
+			FT_ERROR("Font: {} cancelled load still produced a font", font.string());
+			return false;
+		}
+
+		// Cancelled while baking, after the first streamed chunk.
+		std::filesystem::remove_all(CACHE_DIR / "CancelledMidway");
+		std::stop_source midway;
+		FontCfg streamed{ .range = { 32, 0x500 }, .path = font, .max_page_size = 256, .threads = 4, .on_batch = [&](const GlyphBatch&) { midway.request_stop(); } };
+		FontData partial = Library::get().create_font_data_async(CACHE_DIR / "CancelledMidway", streamed, midway.get_token()).get();
+		if (!partial.records.empty() || !partial.pages.empty()) {
+			FT_ERROR("Font: {} cancelled bake returned {} glyphs", font.string(), partial.records.size());
+			return false;
+		}
+		std::error_code ec;
+		for (const auto& entry : std::filesystem::directory_iterator(CACHE_DIR / "CancelledMidway" / "Fonts", ec)) {
+			FT_ERROR("Cancelled bake left {} in the cache", entry.path().string());
+			return false;
+		}
+
+		// A batch from inside an async load runs on a pool worker, with every worker doing the same it must not wait on the pool.
+		std::filesystem::remove_all(CACHE_DIR / "Nested");
+		u32 loads = std::max(1u, std::thread::hardware_concurrency());
+		std::vector<std::vector<FontData>> nested(loads);
+		std::vector<std::future<FontData>> outer;
+		for (u32 i = 0; i < loads; i++) {
+			FontCfg inner[] = { FontCfg{ .pt = 10 + i, .path = font }, FontCfg{ .pt = 10 + i, .range = { 128, 512 }, .path = font } };
+			FontCfg cfg{ .pt = 40 + i, .path = font, .on_batch = [&nested, i, inner](const GlyphBatch&) {
+				if (nested[i].empty()) {
+					nested[i] = Library::get().create_font_data_batch(CACHE_DIR / "Nested", inner);
+				}
+			} };
+			outer.push_back(Library::get().create_font_data_async(CACHE_DIR / "Nested", cfg));
+		}
+		for (u32 i = 0; i < loads; i++) {
+			FontData data = outer[i].get();
+			if (data.records.empty() || nested[i].size() != 2 || nested[i][0].records.empty() || nested[i][1].records.empty()) {
+				FT_ERROR("Font: {} batch inside async load {} returned no fonts", font.string(), i);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool streaming_bake(const std::filesystem::path& font) {
+		// Batches put together must be exactly the font that is returned and cached.
+		std::vector<Glyph> streamed;
+		std::vector<std::vector<unsigned char>> pages;
+		FontCfg cfg{
+			.range         = { 32, 0x500 },
+			.path          = font,
+			.max_page_size = 256,
+			.threads       = 4,
+			.on_batch      = [&](const GlyphBatch& batch) {
+				streamed.insert(streamed.end(), batch.glyphs.begin(), batch.glyphs.end());
+				u32 texel = texel_size(batch.format);
+				pages.resize(std::max<std::size_t>(pages.size(), batch.page + 1));
+				if (pages[batch.page].empty()) {
+					std::vector<unsigned char> blank(std::size_t(batch.page_width) * batch.page_height, 0);
+					pages[batch.page].resize(blank.size() * texel);
+					if (batch.format == EAtlasFormat::R8) {
+						pages[batch.page] = blank;
+					} else {
+						expand_r8_rgba8(blank.data(), pages[batch.page].data(), blank.size());
+					}
+				}
+				for (u32 row = 0; row < batch.rect.h; ++row) {
+					std::memcpy(&pages[batch.page][(std::size_t(batch.rect.y + row) * batch.page_width + batch.rect.x) * texel], &batch.pixels[std::size_t(row) * batch.rect.w * texel], std::size_t(batch.rect.w) * texel);
+				}
+			},
+		};
+		std::filesystem::remove_all(CACHE_DIR / "Streaming");
+		std::filesystem::remove_all(CACHE_DIR / "StreamingSerial");
+		FontData data = Library::get().create_font_data(CACHE_DIR / "Streaming", cfg);
+		if (data.records.empty() || streamed.size() != data.records.size() || std::memcmp(streamed.data(), data.records.data(), data.records.size_bytes()) != 0) {
+			FT_ERROR("Font: {} streamed glyphs differ from the baked font", font.string());
+			return false;
+		}
+		if (pages.size() != data.pages.size() || pages.size() < 2) {
+			FT_ERROR("Font: {} streamed {} pages, baked {}", font.string(), pages.size(), data.pages.size());
+			return false;
+		}
+		for (std::size_t i = 0; i < pages.size(); i++) {
+			MappedAtlas atlas(data.pages[i].raw);
+			if (!atlas.is_open() || atlas.pixels().size() != pages[i].size() || std::memcmp(atlas.pixels().data(), pages[i].data(), pages[i].size()) != 0) {
+				FT_ERROR("Font: {} streamed page {} differs from the baked page", font.string(), i);
+				return false;
+			}
+		}
+
+		streamed.clear();
+		cfg.threads   = 1;
+		FontData serial = Library::get().create_font_data(CACHE_DIR / "StreamingSerial", cfg);
+		if (serial.records.size() != data.records.size() || std::memcmp(serial.records.data(), data.records.data(), data.records.size_bytes()) != 0) {
+			FT_ERROR("Font: {} streamed layout depends on the thread count", font.string());
+			return false;
+		}
+		return true;
+	}
+
+	bool write_behind(const std::filesystem::path& font) {
+		// Written behind or not, the returned font and the cache files must be the same.
+		std::filesystem::remove_all(CACHE_DIR / "WriteBehind");
+		std::filesystem::remove_all(CACHE_DIR / "WriteThrough");
+		for (ECacheLayout layout : { ECacheLayout::FILES, ECacheLayout::BUNDLE }) {
+			FontCfg cfg{ .pt = 22, .range = { 32, 0x500 }, .path = font, .max_page_size = 256, .cache_layout = layout };
+			FontData expected = Library::get().create_font_data(CACHE_DIR / "WriteThrough", cfg);
+			cfg.write_behind  = true;
+			FontData baked    = Library::get().create_font_data(CACHE_DIR / "WriteBehind", cfg);
+			FontData reloaded = Library::get().create_font_data(CACHE_DIR / "WriteBehind", cfg); // Waits for the queued write.
+			Library::get().flush();
+			for (const FontData* data : { &baked, &reloaded }) {
+				if (data->records.empty() || data->records.size() != expected.records.size() ||
+				    std::memcmp(data->records.data(), expected.records.data(), expected.records.size_bytes()) != 0)
+				{
+					FT_ERROR("Font: {} written behind differs from a blocking bake", font.string());
+					return false;
+				}
+			}
+			if (reloaded.pages.size() != expected.pages.size()) {
+				FT_ERROR("Font: {} reloaded {} pages, expected {}", font.string(), reloaded.pages.size(), expected.pages.size());
+				return false;
+			}
+			for (std::size_t i = 0; i < expected.pages.size(); i++) {
+				// A fresh bake hands out its texels in either layout, uploads need not wait for the written files.
+				const auto& fresh = baked.pages[i].pixels;
+				if (fresh.empty() || fresh.size() != expected.pages[i].pixels.size() || std::memcmp(fresh.data(), expected.pages[i].pixels.data(), fresh.size()) != 0) {
+					FT_ERROR("Font: {} page {} texels are missing from the font written behind", font.string(), i);
+					return false;
+				}
+				std::span<const std::byte> want = std::as_bytes(expected.pages[i].pixels);
+				std::span<const std::byte> got  = std::as_bytes(reloaded.pages[i].pixels);
+				std::optional<MappedAtlas> want_raw, got_raw;
+				if (layout == ECacheLayout::FILES) {
+					want = want_raw.emplace(expected.pages[i].raw).pixels();
+					got  = got_raw.emplace(reloaded.pages[i].raw).pixels();
+					if (!std::filesystem::exists(reloaded.pages[i].png)) {
+						FT_ERROR("Font: {} page {} png was not written behind", font.string(), i);
+						return false;
+					}
+				}
+				if (got.empty() || got.size() != want.size() || std::memcmp(got.data(), want.data(), want.size()) != 0) {
+					FT_ERROR("Font: {} page {} written behind differs from a blocking write", font.string(), i);
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	bool failed_page_write(const std::filesystem::path& font) {
+		// A page that fails to write must not leave a glyph file or manifest entry behind, written behind or not.
+		FontCfg cfg{ .pt = 15, .path = font };
+		FontData named = Library::get().create_font_data(CACHE_DIR / "PageWrite", cfg);
+		if (named.pages.empty()) {
+			FT_ERROR("Font: {} baked no pages", font.string());
+			return false;
+		}
+		for (bool behind : { false, true }) {
+			auto dir = CACHE_DIR / (behind ? "PageWriteBehind" : "PageWriteThrough");
+			auto png = dir / "Fonts" / named.pages[0].png.filename();
+			std::filesystem::remove_all(dir);
+			std::filesystem::create_directories(png); // A directory cannot be renamed over.
+			cfg.write_behind = behind;
+			Library::get().create_font_data(dir, cfg);
+			Library::get().flush();
+			for (const auto& entry : std::filesystem::directory_iterator(dir / "Fonts")) {
+				if (entry.path().extension() == ".bin" || entry.path().extension() == ".tmp") {
+					FT_ERROR("Failed page write left {} behind", entry.path().string());
+					return false;
+				}
+			}
+			if (CacheManifest(dir / "Fonts").find(named.key)) {
+				FT_ERROR("Cache manifest lists {:016x} without its pages", named.key);
+				return false;
+			}
+			std::filesystem::remove(png);
+			FontData data = Library::get().create_font_data(dir, cfg);
+			Library::get().flush();
+			if (data.records.empty() || !std::filesystem::exists(data.pages[0].png) || !CacheManifest(dir / "Fonts").find(named.key)) {
+				FT_ERROR("Font: {} was not cached once its pages could be written", font.string());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool concurrent_load(const std::filesystem::path& font) {
+		// Threads race on the same cold cache files, every one must still get a whole font.
+		std::filesystem::remove_all(CACHE_DIR / "Concurrent");
+		std::vector<FontData> results(8);
+		{
+			std::vector<std::jthread> threads;
+			for (std::size_t i = 0; i < results.size(); i++) {
+				threads.emplace_back([&, i] {
+					FontCfg cfg{ .pt = i % 2 ? 14u : 18u, .path = font, .verbose = i == 0 };
+					results[i]  = Library::get().create_font_data(CACHE_DIR / "Concurrent", cfg);
+				});
+			}
+		}
+		for (std::size_t i = 0; i < results.size(); i++) {
+			const FontData& expected = results[i % 2];
+			if (results[i].records.empty() || results[i].records.size() != expected.records.size() ||
+			    std::memcmp(results[i].records.data(), expected.records.data(), expected.records.size_bytes()) != 0)
+			{
+				FT_ERROR("Font: {} concurrent load {} differs", font.string(), i);
+				return false;
+			}
+		}
+		for (const auto& entry : std::filesystem::directory_iterator(CACHE_DIR / "Concurrent" / "Fonts")) {
+			if (entry.path().extension() == ".tmp") {
+				FT_ERROR("Concurrent load left a temp file behind: {}", entry.path().string());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool charset_ranges(const std::filesystem::path& font) {
+		std::filesystem::create_directories(CACHE_DIR);
+		std::filesystem::path charset = CACHE_DIR / "charset.txt";
+		{
+			// "Привет, мир!\n" plus a malformed byte that has to be skipped.
+			std::ofstream file(charset, std::ios::binary);
+			file << "\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82, \xD0\xBC\xD0\xB8\xD1\x80!\n\xFF";
+		}
+		FontCfg cfg{
+			.range   = { 0, 0 },
+			.ranges  = { { U'0', U'9' + 1 }, { U'A', U'Z' + 1 } },
+			.charset = charset,
+			.path    = font,
+		};
+		std::vector<char32_t> expected = { U' ', U'!', U',' };
+		for (char32_t c = U'0'; c <= U'9'; c++) expected.push_back(c);
+		for (char32_t c = U'A'; c <= U'Z'; c++) expected.push_back(c);
+		for (char32_t c : { 0x41F, 0x440, 0x438, 0x432, 0x435, 0x442, 0x43C }) expected.push_back(c);
+		std::sort(expected.begin(), expected.end());
+		expected.erase(std::unique(expected.begin(), expected.end()), expected.end());
+		if (cfg.codepoints() != expected) {
+			FT_ERROR("Charset {} decoded to {} codepoints, expected {}", charset.string(), cfg.codepoints().size(), expected.size());
+			return false;
+		}
+
+		std::filesystem::remove_all(CACHE_DIR / "Charset");
+		for (int pass = 0; pass < 2; pass++) { // Bake, then load from cache.
+			FontData data = Library::get().create_font_data(CACHE_DIR / "Charset", cfg);
+			if (data.records.size() != expected.size()) {
+				FT_ERROR("Font: {} loaded {} glyphs for {} selected codepoints", font.string(), data.records.size(), expected.size());
+				return false;
+			}
+			for (std::size_t i = 0; i < expected.size(); i++) {
+				if (data.records[i].codepoint != expected[i]) {
+					FT_ERROR("Font: {} loaded unexpected glyph {}", font.string(), static_cast<u32>(data.records[i].codepoint));
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	bool cmap_coverage(const std::filesystem::path& font) {
+		// Ranges starting and ending on and off word boundaries survive the round trip.
+		const CharRange synthetic[] = { { 0, 1 }, { 63, 65 }, { 100, 300 }, { 320, 384 }, { 1000, 1001 }, { 0x10000, 0x10FFFE } };
+		Coverage words(synthetic);
+		std::vector<CharRange> round_trip = words.ranges();
+		std::size_t expected_count = 0;
+		for (CharRange range : synthetic) {
+			expected_count += range.end - range.start;
+		}
+		if (round_trip.size() != std::size(synthetic) || std::memcmp(round_trip.data(), synthetic, sizeof(synthetic)) != 0 || words.count() != expected_count ||
+		    words.contains(65) || !words.contains(64) || words.contains(0x10FFFE))
+		{
+			FT_ERROR("Coverage does not reproduce its ranges");
+			return false;
+		}
+
+		FontCfg cfg{
+			.range = { 32, 0x3000 },
+			.path  = font,
+		};
+		std::filesystem::remove_all(CACHE_DIR / "Coverage");
+		std::vector<CharRange> baked;
+		for (int pass = 0; pass < 2; pass++) { // Bake, then load from cache.
+			FontData data = Library::get().create_font_data(CACHE_DIR / "Coverage", cfg);
+			if (data.coverage.empty() || !data.coverage.contains(U'A') || data.coverage.contains(0x4E00)) {
+				FT_ERROR("Font: {} has unexpected cmap coverage", font.string());
+				return false;
+			}
+			std::size_t mapped = 0;
+			for (char32_t c = cfg.range.start; c < cfg.range.end; c++) {
+				mapped += data.coverage.contains(c);
+			}
+			if (data.records.size() != mapped) {
+				FT_ERROR("Font: {} loaded {} glyphs but maps {} codepoints in range", font.string(), data.records.size(), mapped);
+				return false;
+			}
+			for (const Glyph& glyph : data.records) {
+				if (!data.coverage.contains(glyph.codepoint)) {
+					FT_ERROR("Font: {} loaded unmapped codepoint {}", font.string(), static_cast<u32>(glyph.codepoint));
+					return false;
+				}
+			}
+
+			std::vector<CharRange> ranges = data.coverage.ranges();
+			if (pass == 0) {
+				baked = ranges;
+			} else if (ranges.size() != baked.size() || std::memcmp(ranges.data(), baked.data(), ranges.size() * sizeof(CharRange)) != 0) {
+				FT_ERROR("Font: {} cached coverage differs from the baked coverage", font.string());
+				return false;
+			}
+		}
+
+		// Runs read from a file are only trusted when ascending, disjoint and within unicode.
+		const CharRange unordered[] = { { 0, 100000 }, { 5, 6 } };
+		const CharRange huge[]      = { { 0, 0x7FFFFFFF } };
+		const CharRange empty[]     = { { 10, 10 } };
+		if (!Coverage::valid(synthetic) || Coverage::valid(unordered) || Coverage::valid(huge) || Coverage::valid(empty) || Coverage(unordered).contains(100)) {
+			FT_ERROR("Coverage validation is wrong");
+			return false;
+		}
+		FontData cached = Library::get().create_font_data(CACHE_DIR / "Coverage", cfg);
+		auto bin        = CACHE_DIR / "Coverage" / "Fonts" / std::format("{}_{:016x}.bin", font.filename().string(), cached.key);
+		{
+			std::fstream file(bin, std::ios::binary | std::ios::in | std::ios::out);
+			file.seekp(88 + cached.pages.size() * 16); // First coverage run, after the header and page table.
+			file.write(reinterpret_cast<const char*>(huge), sizeof(huge));
+		}
+		FontData rebaked = Library::get().create_font_data(CACHE_DIR / "Coverage", cfg);
+		if (rebaked.coverage.ranges().size() != baked.size() || rebaked.coverage.contains(0x4E00)) {
+			FT_ERROR("Font: {} corrupt cached coverage was loaded", font.string());
+			return false;
+		}
+		return true;
+	}
+
+	bool sdf_atlas(const std::filesystem::path& font) {
+		std::filesystem::remove_all(CACHE_DIR / "Sdf");
+		FontCfg cfg{
+			.pt          = 14,
+			.path        = font,
+			.format      = EAtlasFormat::R8,
+			.render_mode = ERenderMode::SDF,
+			.sdf_pt      = 32,
+			.sdf_spread  = 4,
+		};
+		FontData small = Library::get().create_font_data(CACHE_DIR / "Sdf", cfg);
+		cfg.pt         = 72;
+		FontData large = Library::get().create_font_data(CACHE_DIR / "Sdf", cfg);
+		if (small.pages.size() != 1 || small.pages[0].raw != large.pages[0].raw || large.pt != 32 || large.sdf_spread != 4 || large.render_mode != ERenderMode::SDF) {
+			FT_ERROR("Font: {} SDF atlases of different pt should be shared", font.string());
+			return false;
+		}
+
+		// 128 is the outline, the middle of a stem is inside and the field saturates outside it.
+		const Glyph* glyph = large.find(U'l');
+		MappedAtlas atlas(large.pages[0].raw);
+		if (!glyph || !atlas.is_open() || glyph->size.x < 2 * 4 || glyph->size.y < 2 * 4) {
+			FT_ERROR("Font: {} SDF glyph is missing its spread", font.string());
+			return false;
+		}
+		auto texel = [&](u32 x, u32 y) {
+			return std::to_integer<u32>(atlas.pixels()[std::size_t(y) * atlas.header().row_pitch + x]);
+		};
+		u32 x = glyph->offset % atlas.header().width;
+		u32 y = glyph->offset / atlas.header().width;
+		if (texel(x + static_cast<u32>(glyph->size.x) / 2, y + static_cast<u32>(glyph->size.y) / 2) <= 128 || texel(x, y) >= 128) {
+			FT_ERROR("Font: {} SDF values are not signed around the outline", font.string());
+			return false;
+		}
+		return true;
+	}
+
+	bool dynamic_atlas(const std::filesystem::path& font) {
+		auto atlas = Library::get().create_dynamic_atlas(DynamicAtlasCfg{ .path = font, .width = 64, .height = 64 });
+
+		// Fill the atlas during one frame, smaller glyphs still fit after the first one that does not.
+		std::size_t area = 0;
+		char32_t extra   = 0;
+		for (char32_t c = U'!'; c < 127; c++) {
+			const Glyph* g = atlas->get(c);
+			if (!g) {
+				extra = extra ? extra : c;
+				continue;
+			}
+			if (g->codepoint != c) {
+				FT_ERROR("Dynamic atlas returned {} for {}", static_cast<u32>(g->codepoint), static_cast<u32>(c));
+				return false;
+			}
+			area += std::size_t(g->size.x + 1) * std::size_t(g->size.y + 1);
+		}
+		std::size_t resident = atlas->size();
+		if (resident == 0 || extra == 0) {
+			FT_ERROR("Dynamic atlas should hold some, but not all of ascii, holds {}", resident);
+			return false;
+		}
+		// Glyphs are packed by their own size, a slot for the whole face bounding box wastes most of the page.
+		if (area * 2 < 64 * 64) {
+			FT_ERROR("Dynamic atlas is full with only {} of {} texels covered by {} glyphs", area, 64 * 64, resident);
+			return false;
+		}
+		if (atlas->take_dirty().size() != resident || !atlas->take_dirty().empty()) {
+			FT_ERROR("Dynamic atlas should report one dirty rect per added glyph");
+			return false;
+		}
+
+		// Next frame, touch the first glyph so eviction passes it over.
+		atlas->next_frame();
+		atlas->get(U'!');
+		const Glyph* g = atlas->get(extra);
+		if (!g || atlas->size() > resident || atlas->take_dirty().size() != 1) {
+			FT_ERROR("Dynamic atlas failed to evict for {}", static_cast<u32>(extra));
+			return false;
+		}
+		if (atlas->get(U'!') == nullptr || atlas->get(extra) == nullptr || atlas->take_dirty().size() != 0) {
+			FT_ERROR("Dynamic atlas evicted a glyph used this frame");
+			return false;
+		}
+		return true;
+	}
+
+	std::optional<std::vector<unsigned char>> decode_png(std::span<const unsigned char> png, u32 width, u32 height, u32 channels) {
+		auto be32 = [&](std::size_t at) { return u32(png[at]) << 24 | u32(png[at + 1]) << 16 | u32(png[at + 2]) << 8 | u32(png[at + 3]); };
+		std::vector<unsigned char> zdata;
+		for (std::size_t at = 8; at + 12 <= png.size();) {
+			u32 length = be32(at);
+			if (::crc32(0L, &png[at + 4], length + 4) != be32(at + 8 + length)) return std::nullopt;
+			if (std::memcmp(&png[at + 4], "IHDR", 4) == 0 && (be32(at + 8) != width || be32(at + 12) != height)) return std::nullopt;
+			if (std::memcmp(&png[at + 4], "IDAT", 4) == 0) zdata.insert(zdata.end(), &png[at + 8], &png[at + 8 + length]);
+			at += length + 12;
+		}
+		std::size_t stride = std::size_t(width) * channels;
+		std::vector<unsigned char> filtered(height * (stride + 1));
+		uLongf size = static_cast<uLongf>(filtered.size());
+		if (::uncompress(filtered.data(), &size, zdata.data(), static_cast<uLong>(zdata.size())) != Z_OK || size != filtered.size()) return std::nullopt;
+
+		std::vector<unsigned char> out(height * stride);
+		for (u32 y = 0; y < height; y++) {
+			const unsigned char* src = &filtered[y * (stride + 1)];
+			unsigned char* row       = &out[y * stride];
+			for (std::size_t i = 0; i < stride; i++) {
+				int a = i >= channels ? row[i - channels] : 0;
+				int b = y > 0 ? out[(y - 1) * stride + i] : 0;
+				int c = y > 0 && i >= channels ? out[(y - 1) * stride + i - channels] : 0;
+				int p = a + b - c, pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+				int predict[] = { 0, a, b, (a + b) / 2, pa <= pb && pa <= pc ? a : pb <= pc ? b : c };
+				if (src[0] > 4) return std::nullopt;
+				row[i] = static_cast<unsigned char>(src[i + 1] + predict[src[0]]);
+			}
+		}
+		return out;
+	}
+
+	bool png_encoder() {
+		for (u32 channels : { 1u, 4u }) {
+			u32 width = 333, height = 517;
+			std::vector<unsigned char> pixels(std::size_t(width) * height * channels);
+			for (std::size_t i = 0; i < pixels.size(); i++) {
+				pixels[i] = static_cast<unsigned char>((i / channels) % 7 == 0 ? i * 13 : 0); // Sparse like an atlas.
+			}
+			for (EPngFilter filter : { EPngFilter::NONE, EPngFilter::SUB, EPngFilter::UP, EPngFilter::AVERAGE, EPngFilter::PAETH, EPngFilter::ADAPTIVE }) {
+				PngEncodeCfg cfg{ .level = 6, .filter = filter, .threads = 1, .band_rows = 32 };
+				auto serial = encode_png(pixels, width, height, channels, cfg);
+				cfg.threads   = 4;
+				auto parallel = encode_png(pixels, width, height, channels, cfg);
+				if (serial.empty() || serial != parallel) {
+					FT_ERROR("Png encoding with filter {} depends on the thread count", static_cast<u32>(filter));
+					return false;
+				}
+				if (decode_png(parallel, width, height, channels) != pixels) {
+					FT_ERROR("Png with filter {} and {} channels does not decode to its pixels", static_cast<u32>(filter), channels);
+					return false;
+				}
+			}
+
+			// Pool workers encode inline by default, with the same bytes.
+			ThreadPool pool(2);
+			auto pooled = pool.submit([&] { return std::pair(ThreadPool::on_worker(), encode_png(pixels, width, height, channels)); }).get();
+			if (ThreadPool::on_worker() || !pooled.first || pooled.second != encode_png(pixels, width, height, channels)) {
+				FT_ERROR("Png encoded on a pool worker differs");
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool r8_atlas(const std::filesystem::path& font) {
+		// One byte per texel from the bake through the raw atlas and png to a warm load, matching the red channel of rgba8.
+		std::filesystem::remove_all(CACHE_DIR / "R8");
+		std::filesystem::remove_all(CACHE_DIR / "Rgba8");
+		FontCfg cfg{ .pt = 16, .range = { 32, 0x500 }, .path = font, .max_page_size = 256, .format = EAtlasFormat::RGBA8 };
+		FontData rgba = Library::get().create_font_data(CACHE_DIR / "Rgba8", cfg);
+		cfg.format     = EAtlasFormat::R8;
+		FontData baked = Library::get().create_font_data(CACHE_DIR / "R8", cfg);
+		FontData warm  = Library::get().create_font_data(CACHE_DIR / "R8", cfg);
+		if (baked.storage == warm.storage) {
+			FT_ERROR("Font: {} r8 atlas was not loaded from the cache", font.string());
+			return false;
+		}
+		for (const FontData* data : { &baked, &warm }) {
+			if (data->format != EAtlasFormat::R8 || data->records.empty() || data->records.size() != rgba.records.size() ||
+			    std::memcmp(data->records.data(), rgba.records.data(), rgba.records.size_bytes()) != 0 || data->pages.size() != rgba.pages.size())
+			{
+				FT_ERROR("Font: {} r8 glyphs differ from the rgba8 glyphs", font.string());
+				return false;
+			}
+			for (std::size_t i = 0; i < data->pages.size(); i++) {
+				const AtlasPage& page = data->pages[i];
+				MappedAtlas atlas(page.raw);
+				MappedAtlas expanded(rgba.pages[i].raw);
+				std::size_t texels = std::size_t(page.width) * page.height;
+				if (!atlas.is_open() || atlas.header().format != EAtlasFormat::R8 || atlas.header().row_pitch != page.width || atlas.pixels().size() != texels) {
+					FT_ERROR("Font: {} r8 page {} is not one byte per texel", font.string(), i);
+					return false;
+				}
+				for (std::size_t t = 0; t < texels; t++) {
+					if (atlas.pixels()[t] != expanded.pixels()[t * 4]) {
+						FT_ERROR("Font: {} r8 page {} texel {} differs from rgba8", font.string(), i, t);
+						return false;
+					}
+				}
+
+				std::vector<unsigned char> png(std::filesystem::file_size(page.png));
+				std::ifstream(page.png, std::ios::binary).read(reinterpret_cast<char*>(png.data()), png.size());
+				constexpr std::size_t COLOR_TYPE = 8 + 8 + 9; // Signature, IHDR length and type, width, height, depth.
+				auto pixels = decode_png(png, page.width, page.height, 1);
+				if (png.size() <= COLOR_TYPE || png[COLOR_TYPE] != 0 || !pixels || std::memcmp(pixels->data(), atlas.pixels().data(), texels) != 0) {
+					FT_ERROR("Font: {} r8 page {} png is not the gray atlas", font.string(), i);
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	bool expand_kernels() {
+		std::vector<unsigned char> src(1031); // Odd size so every kernel runs its tail.
+		for (std::size_t i = 0; i < src.size(); i++) {
+			src[i] = static_cast<unsigned char>(i * 7);
+		}
+		std::vector<unsigned char> expected(src.size() * 4);
+		expand_r8_rgba8(src.data(), expected.data(), src.size(), EKernelIsa::SCALAR);
+		for (EKernelIsa isa : { EKernelIsa::SSE2, EKernelIsa::AVX2, EKernelIsa::NEON }) {
+			if (!kernel_supported(isa)) continue;
+			std::vector<unsigned char> out(expected.size());
+			expand_r8_rgba8(src.data(), out.data(), src.size(), isa);
+			if (out != expected) {
+				FT_ERROR("The {} expansion kernel differs from the scalar one", kernel_isa_name(isa));
+				return false;
+			}
+		}
+
+		// FreeType bitmaps with a negative pitch store their bottom row first.
+		const unsigned char upward[] = { 7, 8, 9, 0, 4, 5, 6, 0, 1, 2, 3, 0 };
+		unsigned char rows[9]        = {};
+		blit_rows(top_row(upward, -4, 3), -4, rows, 3, 3, 3);
+		for (u32 i = 0; i < 9; i++) {
+			if (rows[i] != i + 1) {
+				FT_ERROR("blit_rows of an upward bitmap put {} at {}", rows[i], i);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool pack_atlas(u32 max_size) {
+		std::vector<Rect> sizes;
+		for (u32 i = 0; i < 500; i++) {
+			sizes.push_back(Rect{ .w = 1 + (i * 7) % 23, .h = 1 + (i * 13) % 31 });
+		}
+
+		AtlasLayout layout;
+		u32 padding = 1;
+		if (!layout_atlas(sizes, max_size, padding, false, layout)) {
+			FT_ERROR("Failed to pack {} rects", sizes.size());
+			return false;
+		}
+
+		for (std::size_t i = 0; i < layout.rects.size(); i++) {
+			const Rect& a                 = layout.rects[i];
+			const AtlasLayout::Page& page = layout.pages[layout.page[i]];
+			if (page.width > max_size || page.height > max_size) {
+				FT_ERROR("Page {} is {}x{}, larger than {}", layout.page[i], page.width, page.height, max_size);
+				return false;
+			}
+			if (a.x + a.w > page.width || a.y + a.h > page.height) {
+				FT_ERROR("Rect {} is out of page bounds", i);
+				return false;
+			}
+			for (std::size_t j = i + 1; j < layout.rects.size(); j++) {
+				const Rect& b = layout.rects[j];
+				if (layout.page[i] != layout.page[j]) continue;
+				if (a.x < b.x + b.w + padding && b.x < a.x + a.w + padding && a.y < b.y + b.h + padding && b.y < a.y + a.h + padding) {
+					FT_ERROR("Rect {} overlaps rect {}", i, j);
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	bool odd_page_size(const std::filesystem::path& font) {
+		// GPU limits are not always powers of two, such pages must still hold the whole font.
+		std::filesystem::remove_all(CACHE_DIR / "OddPages");
+		FontCfg cfg{ .range = { 32, 0x500 }, .path = font, .max_page_size = 300 };
+		FontData data = Library::get().create_font_data(CACHE_DIR / "OddPages", cfg);
+		if (data.records.empty() || data.pages.empty()) {
+			FT_ERROR("Font: {} did not bake with {} texel pages", font.string(), cfg.max_page_size);
+			return false;
+		}
+		for (const AtlasPage& page : data.pages) {
+			if (page.width > cfg.max_page_size || page.height > cfg.max_page_size) {
+				FT_ERROR("Font: {} has a {}x{} page, larger than {}", font.string(), page.width, page.height, cfg.max_page_size);
+				return false;
+			}
+		}
+
+		// Page sizes past 2^31 must not wrap the power of two search, nor be baked into 32 bit glyph offsets.
+		AtlasLayout layout;
+		std::vector<Rect> sizes(16, Rect{ .w = 10, .h = 12 });
+		if (!layout_atlas(sizes, 1u << 31, 1, false, layout) || layout.pages.size() != 1 || layout.pages[0].width > 64) {
+			FT_ERROR("Failed to pack into a 2^31 texel page");
+			return false;
+		}
+		cfg.max_page_size = 1u << 31;
+		FontData huge     = Library::get().create_font_data(CACHE_DIR / "OddPages", cfg);
+		if (!huge.records.empty()) {
+			FT_ERROR("Font: {} baked with {} texel pages", font.string(), cfg.max_page_size);
+			return false;
+		}
+		return true;
+	}
+
+	bool serializer_save() {
+		// A save that cannot replace its target fails without leaving its temp file behind.
+		auto dir = CACHE_DIR / "Save";
+		std::filesystem::remove_all(dir);
+		std::filesystem::create_directories(dir / "target"); // A directory cannot be renamed over.
+		u64 value = 42;
+		Serializer serializer(SerializeOpts{ .file = dir / "target", .mode = ESerializeMode::WRITE });
+		serializer.write_span(std::span<const u64>(&value, 1));
+		if (serializer.save()) {
+			FT_ERROR("Serializer replaced a directory: {}", (dir / "target").string());
+			return false;
+		}
+		unsigned char texel = 0;
+		if (write_raw_atlas(dir / "target", 1, 1, EAtlasFormat::R8, std::span(&texel, 1))) {
+			FT_ERROR("Raw atlas replaced a directory: {}", (dir / "target").string());
+			return false;
+		}
+		if (write_png(dir / "target", std::span(&texel, 1), 1, 1, 1)) {
+			FT_ERROR("Png replaced a directory: {}", (dir / "target").string());
+			return false;
+		}
+		for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+			if (entry.path().extension() == ".tmp") {
+				FT_ERROR("Failed save left {} behind", entry.path().string());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool failed_bake(const std::filesystem::path& font) {
+		// Glyphs larger than a page fail the bake, that must not leave a cache entry behind.
+		std::filesystem::remove_all(CACHE_DIR / "FailedBake");
+		FontCfg cfg{ .pt = 200, .path = font, .max_page_size = 64 };
+		for (int i = 0; i < 4; i++) {
+			if (i == 2) {
+				cfg.range    = { 32, 0x500 }; // Packing fails while workers still rasterize.
+				cfg.threads  = 4;
+				cfg.on_batch = [](const GlyphBatch&) {};
+			}
+			FontData data = Library::get().create_font_data(CACHE_DIR / "FailedBake", cfg);
+			if (!data.records.empty() || !data.pages.empty()) {
+				FT_ERROR("Font: {} returned {} glyphs from a failed bake", font.string(), data.records.size());
+				return false;
+			}
+		}
+		std::error_code ec;
+		for (const auto& entry : std::filesystem::directory_iterator(CACHE_DIR / "FailedBake" / "Fonts", ec)) {
+			FT_ERROR("Failed bake left {} in the cache", entry.path().string());
+			return false;
+		}
+		return true;
+	}
+
 } // namespace aby::ft::test
 
 int main(int argc, char** argv) {
@@ -68,6 +1284,7 @@ int main(int argc, char** argv) {
 			info += "  Name:   " + fd.name + "\n";
 			info += "  Mono:   " + std::to_string(fd.is_mono) + "\n";
 			info += "  PNG:    " + fd.png.string() + "\n";
+			info += "  Pages:  " + std::to_string(fd.pages.size()) + "\n";
 			info += "  Height: " + std::to_string(fd.text_height) + "\n";
 			info += "  Glyphs: " + std::to_string(fd.glyphs.size())  + "\n";
 			for (auto& [c, g] : fd.glyphs) {
@@ -84,9 +1301,218 @@ int main(int argc, char** argv) {
 			}
 			aby::util::pretty_print(info, "AbyssFTTest");
 
+			if (!aby::ft::test::find_records(fd)) {
+				FT_ERROR("Test Failed: {}", "Find Records");
+				res = 1;
+			} else {
+				FT_STATUS("Test Succeeded: {}", "Find Records");
+			}
+
+			if (!aby::ft::test::map_raw_atlas(fd)) {
+				FT_ERROR("Test Failed: {}", "Map Raw Atlas");
+				res = 1;
+			} else {
+				FT_STATUS("Test Succeeded: {}", "Map Raw Atlas");
+			}
 		}
 	}
 
+	if (!aby::ft::test::dense_lookup(font_dir / "IBMPlexMono" / "IBMPlexMono-Regular.ttf")) {
+		FT_ERROR("Test Failed: {}", "Dense Lookup");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Dense Lookup");
+	}
+
+	if (!aby::ft::test::perfect_hash_lookup(font_dir / "IBMPlexMono" / "IBMPlexMono-Regular.ttf")) {
+		FT_ERROR("Test Failed: {}", "Perfect Hash Lookup");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Perfect Hash Lookup");
+	}
+
+	if (!aby::ft::test::corrupt_glyph_count(font_dir / "IBMPlexMono" / "IBMPlexMono-Regular.ttf")) {
+		FT_ERROR("Test Failed: {}", "Corrupt Glyph Count");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Corrupt Glyph Count");
+	}
+
+	if (!aby::ft::test::parallel_raster(font_dir / "IBMPlexMono" / "IBMPlexMono-Regular.ttf")) {
+		FT_ERROR("Test Failed: {}", "Parallel Raster");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Parallel Raster");
+	}
+
+	if (!aby::ft::test::batch_load(font_dir / "IBMPlexMono" / "IBMPlexMono-Regular.ttf")) {
+		FT_ERROR("Test Failed: {}", "Batch Load");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Batch Load");
+	}
+
+	if (!aby::ft::test::face_cache(font_dir / "IBMPlexMono" / "IBMPlexMono-Regular.ttf")) {
+		FT_ERROR("Test Failed: {}", "Face Cache");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Face Cache");
+	}
+
+	if (!aby::ft::test::mapped_font(font_dir / "IBMPlexMono" / "IBMPlexMono-Regular.ttf")) {
+		FT_ERROR("Test Failed: {}", "Mapped Font");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Mapped Font");
+	}
+
+	if (!aby::ft::test::cache_key(font_dir / "IBMPlexMono" / "IBMPlexMono-Regular.ttf")) {
+		FT_ERROR("Test Failed: {}", "Cache Key");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Cache Key");
+	}
+
+	if (!aby::ft::test::cache_bundle(font_dir / "IBMPlexMono" / "IBMPlexMono-Regular.ttf")) {
+		FT_ERROR("Test Failed: {}", "Cache Bundle");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Cache Bundle");
+	}
+
+	if (!aby::ft::test::cache_manifest(font_dir / "IBMPlexMono" / "IBMPlexMono-Regular.ttf")) {
+		FT_ERROR("Test Failed: {}", "Cache Manifest");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Cache Manifest");
+	}
+
+	if (!aby::ft::test::async_load(font_dir / "IBMPlexMono" / "IBMPlexMono-Regular.ttf")) {
+		FT_ERROR("Test Failed: {}", "Async Load");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Async Load");
+	}
+
+	if (!aby::ft::test::streaming_bake(font_dir / "IBMPlexMono" / "IBMPlexMono-Regular.ttf")) {
+		FT_ERROR("Test Failed: {}", "Streaming Bake");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Streaming Bake");
+	}
+
+	if (!aby::ft::test::write_behind(font_dir / "IBMPlexMono" / "IBMPlexMono-Regular.ttf")) {
+		FT_ERROR("Test Failed: {}", "Write Behind");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Write Behind");
+	}
+
+	if (!aby::ft::test::failed_page_write(font_dir / "IBMPlexMono" / "IBMPlexMono-Regular.ttf")) {
+		FT_ERROR("Test Failed: {}", "Failed Page Write");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Failed Page Write");
+	}
+
+	if (!aby::ft::test::concurrent_load(font_dir / "IBMPlexMono" / "IBMPlexMono-Regular.ttf")) {
+		FT_ERROR("Test Failed: {}", "Concurrent Load");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Concurrent Load");
+	}
+
+	if (!aby::ft::test::charset_ranges(font_dir / "IBMPlexMono" / "IBMPlexMono-Regular.ttf")) {
+		FT_ERROR("Test Failed: {}", "Charset Ranges");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Charset Ranges");
+	}
+
+	if (!aby::ft::test::cmap_coverage(font_dir / "IBMPlexMono" / "IBMPlexMono-Regular.ttf")) {
+		FT_ERROR("Test Failed: {}", "Cmap Coverage");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Cmap Coverage");
+	}
+
+	if (!aby::ft::test::sdf_atlas(font_dir / "IBMPlexMono" / "IBMPlexMono-Regular.ttf")) {
+		FT_ERROR("Test Failed: {}", "SDF Atlas");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "SDF Atlas");
+	}
+
+	if (!aby::ft::test::dynamic_atlas(font_dir / "IBMPlexMono" / "IBMPlexMono-Regular.ttf")) {
+		FT_ERROR("Test Failed: {}", "Dynamic Atlas");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Dynamic Atlas");
+	}
+
+	if (!aby::ft::test::png_encoder()) {
+		FT_ERROR("Test Failed: {}", "Png Encoder");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Png Encoder");
+	}
+
+	if (!aby::ft::test::r8_atlas(font_dir / "IBMPlexMono" / "IBMPlexMono-Regular.ttf")) {
+		FT_ERROR("Test Failed: {}", "R8 Atlas");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "R8 Atlas");
+	}
+
+	if (!aby::ft::test::expand_kernels()) {
+		FT_ERROR("Test Failed: {}", "Expand Kernels");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Expand Kernels");
+	}
+
+	if (!aby::ft::test::pack_atlas(4096)) {
+		FT_ERROR("Test Failed: {}", "Pack Atlas");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Pack Atlas");
+	}
+
+	if (!aby::ft::test::pack_atlas(64)) {
+		FT_ERROR("Test Failed: {}", "Pack Atlas Pages");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Pack Atlas Pages");
+	}
+
+	if (!aby::ft::test::pack_atlas(100)) {
+		FT_ERROR("Test Failed: {}", "Pack Atlas Odd Pages");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Pack Atlas Odd Pages");
+	}
+
+	if (!aby::ft::test::serializer_save()) {
+		FT_ERROR("Test Failed: {}", "Serializer Save");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Serializer Save");
+	}
+
+	if (!aby::ft::test::failed_bake(font_dir / "IBMPlexMono" / "IBMPlexMono-Regular.ttf")) {
+		FT_ERROR("Test Failed: {}", "Failed Bake");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Failed Bake");
+	}
+
+	if (!aby::ft::test::odd_page_size(font_dir / "IBMPlexMono" / "IBMPlexMono-Regular.ttf")) {
+		FT_ERROR("Test Failed: {}", "Odd Page Size");
+		res = 1;
+	} else {
+		FT_STATUS("Test Succeeded: {}", "Odd Page Size");
+	}
+
 	
 	return res;
 }